@@ -0,0 +1,470 @@
+// Воспроизводимый замер производительности поискового сервера на синтетическом корпусе.
+// Частоты слов в документах и длины запросов распределены по Ципфу, генератор задаётся seed,
+// поэтому при одинаковых параметрах корпус и запросы одинаковы от запуска к запуску.
+// Результат — JSON в stdout (или в файл из --output), ход замеров печатается в stderr.
+//
+//     search_benchmark --documents=20000 --vocabulary=50000 --zipf=1.0 --output=bench.json
+
+#include "process_queries.h"
+#include "remove_duplicates.h"
+#include "search_server.h"
+
+#include <sys/resource.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <execution>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+using namespace std;
+
+struct BenchmarkOptions {
+    size_t document_count = 20'000;
+    size_t vocabulary_size = 50'000;
+    // показатель распределения Ципфа для частот слов и длин запросов
+    double zipf_exponent = 1.0;
+    // длина документа равномерно распределена в [document_length / 2, document_length * 3 / 2]
+    size_t document_length = 100;
+    size_t query_count = 2'000;
+    size_t max_query_length = 8;
+    double minus_word_probability = 0.1;
+    // самые частые слова словаря объявляются стоп-словами
+    size_t stop_word_count = 10;
+    // доля документов, к которым для RemoveDuplicates добавляется дубликат
+    double duplicate_fraction = 0.05;
+    // доля документов, удаляемых в замере RemoveDocument
+    double remove_fraction = 0.1;
+    size_t process_queries_repetitions = 5;
+    uint64_t seed = 42;
+    string output;
+};
+
+struct BenchmarkResult {
+    string name;
+    size_t operation_count = 0;
+    // элементов (документов, запросов) на одну операцию
+    size_t items_per_operation = 1;
+    double seconds = 0.0;
+    double operations_per_second = 0.0;
+    double items_per_second = 0.0;
+    double mean_ns = 0.0;
+    int64_t p50_ns = 0;
+    int64_t p99_ns = 0;
+    int64_t max_ns = 0;
+    // сумма, зависящая от результатов операций: расхождение между версиями означает изменение поведения
+    double checksum = 0.0;
+    long peak_rss_kb = 0;
+};
+
+// Выбор номера от 0 до size - 1 с вероятностью, пропорциональной 1 / (номер + 1)^exponent
+class ZipfDistribution {
+public:
+    ZipfDistribution(size_t size, double exponent) {
+        if (size == 0) {
+            throw invalid_argument("Zipf distribution needs at least one value"s);
+        }
+        cumulative_.reserve(size);
+        double sum = 0.0;
+        for (size_t rank = 1; rank <= size; ++rank) {
+            sum += 1.0 / pow(static_cast<double>(rank), exponent);
+            cumulative_.push_back(sum);
+        }
+    }
+
+    template <typename Generator>
+    size_t operator()(Generator& generator) const {
+        const double value = uniform_real_distribution<double>(0.0, cumulative_.back())(generator);
+        const auto it = upper_bound(cumulative_.begin(), cumulative_.end(), value);
+        return min<size_t>(it - cumulative_.begin(), cumulative_.size() - 1);
+    }
+
+private:
+    vector<double> cumulative_;
+};
+
+struct Workload {
+    vector<string> vocabulary;
+    string stop_words;
+    vector<string> documents;
+    vector<vector<int>> ratings;
+    vector<string> queries;
+};
+
+// слово номер index: запись index + 26 в системе счисления из 26 букв, не короче двух букв
+string MakeWord(size_t index) {
+    string word;
+    for (size_t value = index + 26; value > 0; value /= 26) {
+        word.push_back(static_cast<char>('a' + value % 26));
+    }
+    return word;
+}
+
+Workload GenerateWorkload(const BenchmarkOptions& options) {
+    mt19937_64 generator(options.seed);
+    Workload workload;
+
+    workload.vocabulary.reserve(options.vocabulary_size);
+    for (size_t i = 0; i < options.vocabulary_size; ++i) {
+        workload.vocabulary.push_back(MakeWord(i));
+    }
+    for (size_t i = 0; i < min(options.stop_word_count, options.vocabulary_size); ++i) {
+        workload.stop_words += workload.vocabulary[i] + ' ';
+    }
+
+    const ZipfDistribution word_distribution(options.vocabulary_size, options.zipf_exponent);
+    uniform_int_distribution<size_t> length_distribution(max<size_t>(options.document_length / 2, 1), max<size_t>(options.document_length * 3 / 2, 1));
+    uniform_int_distribution<int> rating_distribution(-10, 10);
+    workload.documents.reserve(options.document_count);
+    workload.ratings.reserve(options.document_count);
+    for (size_t i = 0; i < options.document_count; ++i) {
+        string document;
+        const size_t length = length_distribution(generator);
+        for (size_t j = 0; j < length; ++j) {
+            if (j > 0) {
+                document.push_back(' ');
+            }
+            document += workload.vocabulary[word_distribution(generator)];
+        }
+        workload.documents.push_back(move(document));
+        workload.ratings.push_back({rating_distribution(generator), rating_distribution(generator), rating_distribution(generator)});
+    }
+
+    const ZipfDistribution query_length_distribution(max<size_t>(options.max_query_length, 1), options.zipf_exponent);
+    bernoulli_distribution minus_distribution(options.minus_word_probability);
+    workload.queries.reserve(options.query_count);
+    for (size_t i = 0; i < options.query_count; ++i) {
+        string query;
+        const size_t length = query_length_distribution(generator) + 1;
+        for (size_t j = 0; j < length; ++j) {
+            if (j > 0) {
+                query.push_back(' ');
+            }
+            // первое слово всегда плюс-слово, иначе запрос ничего не найдёт
+            if (j > 0 && minus_distribution(generator)) {
+                query.push_back('-');
+            }
+            query += workload.vocabulary[word_distribution(generator)];
+        }
+        workload.queries.push_back(move(query));
+    }
+    return workload;
+}
+
+long GetPeakRssKilobytes() {
+    rusage usage{};
+    getrusage(RUSAGE_SELF, &usage);
+    // в Linux ru_maxrss — в килобайтах
+    return usage.ru_maxrss;
+}
+
+// Выполняет operation(i) для i из [0, operation_count), замеряя каждый вызов; operation возвращает вклад в checksum
+template <typename Operation>
+BenchmarkResult Measure(string name, size_t operation_count, size_t items_per_operation, Operation operation) {
+    using Clock = chrono::steady_clock;
+    cerr << name << "..."s << endl;
+
+    BenchmarkResult result;
+    result.name = move(name);
+    result.operation_count = operation_count;
+    result.items_per_operation = items_per_operation;
+
+    vector<int64_t> latencies(operation_count);
+    const auto start_time = Clock::now();
+    for (size_t i = 0; i < operation_count; ++i) {
+        const auto operation_start_time = Clock::now();
+        result.checksum += operation(i);
+        latencies[i] = chrono::duration_cast<chrono::nanoseconds>(Clock::now() - operation_start_time).count();
+    }
+    result.seconds = chrono::duration<double>(Clock::now() - start_time).count();
+    result.peak_rss_kb = GetPeakRssKilobytes();
+    if (operation_count == 0) {
+        return result;
+    }
+
+    if (result.seconds > 0) {
+        result.operations_per_second = operation_count / result.seconds;
+        result.items_per_second = operation_count * items_per_operation / result.seconds;
+    }
+    double total_ns = 0;
+    for (const int64_t latency : latencies) {
+        total_ns += latency;
+    }
+    result.mean_ns = total_ns / operation_count;
+    sort(latencies.begin(), latencies.end());
+    const auto get_percentile = [&latencies](double quantile) {
+        return latencies[min(latencies.size() - 1, static_cast<size_t>(quantile * latencies.size()))];
+    };
+    result.p50_ns = get_percentile(0.5);
+    result.p99_ns = get_percentile(0.99);
+    result.max_ns = latencies.back();
+    return result;
+}
+
+double SumRelevance(const vector<Document>& documents) {
+    double sum = 0.0;
+    for (const Document& document : documents) {
+        sum += document.relevance;
+    }
+    return sum;
+}
+
+template <typename ExecutionPolicy>
+BenchmarkResult BenchmarkFindTopDocuments(string name, const SearchServer& search_server, const vector<string>& queries, ExecutionPolicy policy) {
+    return Measure(move(name), queries.size(), 1, [&](size_t i) {
+        return SumRelevance(search_server.FindTopDocuments(policy, queries[i]));
+    });
+}
+
+template <typename ExecutionPolicy>
+BenchmarkResult BenchmarkFindTopDocumentsWithPredicate(string name, const SearchServer& search_server, const vector<string>& queries, ExecutionPolicy policy) {
+    return Measure(move(name), queries.size(), 1, [&](size_t i) {
+        return SumRelevance(search_server.FindTopDocuments(policy, queries[i], [](int document_id, DocumentStatus, int rating) {
+            return document_id % 2 == 0 && rating > 0;
+        }));
+    });
+}
+
+// документ для каждого запроса выбирается заранее, одинаково для всех политик
+template <typename ExecutionPolicy>
+BenchmarkResult BenchmarkMatchDocument(string name, const SearchServer& search_server, const vector<string>& queries, const vector<int>& document_ids, ExecutionPolicy policy) {
+    return Measure(move(name), queries.size(), 1, [&](size_t i) {
+        const auto [words, status] = search_server.MatchDocument(policy, queries[i], document_ids[i]);
+        return static_cast<double>(words.size());
+    });
+}
+
+template <typename ExecutionPolicy>
+BenchmarkResult BenchmarkMatchDocuments(string name, const SearchServer& search_server, const vector<string>& queries, ExecutionPolicy policy) {
+    return Measure(move(name), queries.size(), search_server.GetDocumentCount(), [&](size_t i) {
+        return static_cast<double>(search_server.MatchDocuments(policy, queries[i]).words.size());
+    });
+}
+
+vector<BenchmarkResult> RunBenchmarks(const BenchmarkOptions& options, const Workload& workload) {
+    vector<BenchmarkResult> results;
+    mt19937_64 generator(options.seed + 1);
+
+    SearchServer search_server(workload.stop_words);
+    results.push_back(Measure("AddDocument"s, workload.documents.size(), 1, [&](size_t i) {
+        search_server.AddDocument(static_cast<int>(i), workload.documents[i], DocumentStatus::ACTUAL, workload.ratings[i]);
+        return 0.0;
+    }));
+
+    results.push_back(BenchmarkFindTopDocuments("FindTopDocuments/seq"s, search_server, workload.queries, execution::seq));
+    results.push_back(BenchmarkFindTopDocuments("FindTopDocuments/par"s, search_server, workload.queries, execution::par));
+    results.push_back(BenchmarkFindTopDocumentsWithPredicate("FindTopDocuments/seq/predicate"s, search_server, workload.queries, execution::seq));
+    results.push_back(BenchmarkFindTopDocumentsWithPredicate("FindTopDocuments/par/predicate"s, search_server, workload.queries, execution::par));
+
+    vector<int> match_document_ids(workload.queries.size());
+    if (!workload.documents.empty()) {
+        uniform_int_distribution<int> document_distribution(0, static_cast<int>(workload.documents.size()) - 1);
+        for (int& document_id : match_document_ids) {
+            document_id = document_distribution(generator);
+        }
+    }
+    results.push_back(BenchmarkMatchDocument("MatchDocument/seq"s, search_server, workload.queries, match_document_ids, execution::seq));
+    results.push_back(BenchmarkMatchDocument("MatchDocument/par"s, search_server, workload.queries, match_document_ids, execution::par));
+
+    // матчинг запроса со всеми документами корпуса; запросов меньше, потому что каждый обходит весь корпус
+    const vector<string> match_all_queries(workload.queries.begin(), workload.queries.begin() + min<size_t>(workload.queries.size(), 100));
+    results.push_back(BenchmarkMatchDocuments("MatchDocuments/seq"s, search_server, match_all_queries, execution::seq));
+    results.push_back(BenchmarkMatchDocuments("MatchDocuments/par"s, search_server, match_all_queries, execution::par));
+
+    results.push_back(Measure("ProcessQueries"s, options.process_queries_repetitions, workload.queries.size(), [&](size_t) {
+        double checksum = 0.0;
+        for (const auto& documents : ProcessQueries(search_server, workload.queries)) {
+            checksum += SumRelevance(documents);
+        }
+        return checksum;
+    }));
+
+    {
+        vector<int> removed_ids(search_server.begin(), search_server.end());
+        shuffle(removed_ids.begin(), removed_ids.end(), generator);
+        removed_ids.resize(static_cast<size_t>(removed_ids.size() * options.remove_fraction));
+        SearchServer copy = search_server;
+        results.push_back(Measure("RemoveDocument"s, removed_ids.size(), 1, [&](size_t i) {
+            copy.RemoveDocument(removed_ids[i]);
+            return 0.0;
+        }));
+    }
+
+    {
+        // дубликат — тот же набор слов в другом порядке
+        SearchServer copy = search_server;
+        int next_id = static_cast<int>(workload.documents.size());
+        bernoulli_distribution duplicate_distribution(options.duplicate_fraction);
+        for (size_t i = 0; i < workload.documents.size(); ++i) {
+            if (!duplicate_distribution(generator)) {
+                continue;
+            }
+            auto words = SplitIntoWords(workload.documents[i]);
+            shuffle(words.begin(), words.end(), generator);
+            string duplicate;
+            for (const string& word : words) {
+                duplicate += word + ' ';
+            }
+            copy.AddDocument(next_id++, duplicate, DocumentStatus::ACTUAL, workload.ratings[i]);
+        }
+        // RemoveDuplicates печатает удалённые id в cout, а там JSON
+        ostringstream removed_log;
+        auto* const cout_buffer = cout.rdbuf(removed_log.rdbuf());
+        results.push_back(Measure("RemoveDuplicates"s, 1, copy.GetDocumentCount(), [&](size_t) {
+            const int document_count = copy.GetDocumentCount();
+            RemoveDuplicates(copy);
+            return static_cast<double>(document_count - copy.GetDocumentCount());
+        }));
+        cout.rdbuf(cout_buffer);
+    }
+    return results;
+}
+
+void WriteJson(ostream& out, const BenchmarkOptions& options, const vector<BenchmarkResult>& results) {
+    out << setprecision(10);
+    out << "{\n"s;
+    out << "  \"options\": {\n"s
+        << "    \"documents\": "s << options.document_count << ",\n"s
+        << "    \"vocabulary\": "s << options.vocabulary_size << ",\n"s
+        << "    \"zipf\": "s << options.zipf_exponent << ",\n"s
+        << "    \"document_length\": "s << options.document_length << ",\n"s
+        << "    \"queries\": "s << options.query_count << ",\n"s
+        << "    \"max_query_length\": "s << options.max_query_length << ",\n"s
+        << "    \"minus_word_probability\": "s << options.minus_word_probability << ",\n"s
+        << "    \"stop_words\": "s << options.stop_word_count << ",\n"s
+        << "    \"duplicate_fraction\": "s << options.duplicate_fraction << ",\n"s
+        << "    \"remove_fraction\": "s << options.remove_fraction << ",\n"s
+        << "    \"process_queries_repetitions\": "s << options.process_queries_repetitions << ",\n"s
+        << "    \"seed\": "s << options.seed << "\n"s
+        << "  },\n"s;
+    out << "  \"benchmarks\": [\n"s;
+    for (size_t i = 0; i < results.size(); ++i) {
+        const BenchmarkResult& result = results[i];
+        // имена замеров состоят из латинских букв и '/', экранирование не нужно
+        out << "    {\"name\": \""s << result.name << "\""s
+            << ", \"operations\": "s << result.operation_count
+            << ", \"items_per_operation\": "s << result.items_per_operation
+            << ", \"seconds\": "s << result.seconds
+            << ", \"ops_per_sec\": "s << result.operations_per_second
+            << ", \"items_per_sec\": "s << result.items_per_second
+            << ", \"mean_ns\": "s << result.mean_ns
+            << ", \"p50_ns\": "s << result.p50_ns
+            << ", \"p99_ns\": "s << result.p99_ns
+            << ", \"max_ns\": "s << result.max_ns
+            << ", \"checksum\": "s << result.checksum
+            << ", \"peak_rss_kb\": "s << result.peak_rss_kb << "}"s
+            << (i + 1 < results.size() ? ",\n"s : "\n"s);
+    }
+    out << "  ],\n"s;
+    out << "  \"peak_rss_kb\": "s << GetPeakRssKilobytes() << "\n"s;
+    out << "}"s << endl;
+}
+
+void PrintUsage(ostream& out) {
+    const BenchmarkOptions defaults;
+    out << "Usage: search_benchmark [--option=value]...\n"s
+        << "  --documents=N               documents in the corpus ("s << defaults.document_count << ")\n"s
+        << "  --vocabulary=N              distinct words ("s << defaults.vocabulary_size << ")\n"s
+        << "  --zipf=S                    Zipf exponent for word frequencies and query lengths ("s << defaults.zipf_exponent << ")\n"s
+        << "  --document-length=N         mean words per document ("s << defaults.document_length << ")\n"s
+        << "  --queries=N                 queries ("s << defaults.query_count << ")\n"s
+        << "  --max-query-length=N        words per query, at most ("s << defaults.max_query_length << ")\n"s
+        << "  --minus-words=P             probability of a minus word ("s << defaults.minus_word_probability << ")\n"s
+        << "  --stop-words=N              most frequent words used as stop words ("s << defaults.stop_word_count << ")\n"s
+        << "  --duplicates=P              share of documents duplicated for RemoveDuplicates ("s << defaults.duplicate_fraction << ")\n"s
+        << "  --remove=P                  share of documents removed by RemoveDocument ("s << defaults.remove_fraction << ")\n"s
+        << "  --process-queries-runs=N    ProcessQueries repetitions ("s << defaults.process_queries_repetitions << ")\n"s
+        << "  --seed=N                    random seed ("s << defaults.seed << ")\n"s
+        << "  --output=FILE               write JSON to FILE instead of stdout\n"s
+        << "  --help                      print this message and exit\n"s;
+}
+
+BenchmarkOptions ParseOptions(int argc, char* argv[]) {
+    BenchmarkOptions options;
+    for (int i = 1; i < argc; ++i) {
+        const string_view argument = argv[i];
+        const size_t separator = argument.find('=');
+        if (argument.substr(0, 2) != "--"sv || separator == string_view::npos) {
+            throw invalid_argument("Unexpected argument "s + string(argument));
+        }
+        const string_view name = argument.substr(2, separator - 2);
+        const string value(argument.substr(separator + 1));
+        if (name == "documents"sv) {
+            options.document_count = stoull(value);
+        } else if (name == "vocabulary"sv) {
+            options.vocabulary_size = stoull(value);
+        } else if (name == "zipf"sv) {
+            options.zipf_exponent = stod(value);
+        } else if (name == "document-length"sv) {
+            options.document_length = stoull(value);
+        } else if (name == "queries"sv) {
+            options.query_count = stoull(value);
+        } else if (name == "max-query-length"sv) {
+            options.max_query_length = stoull(value);
+        } else if (name == "minus-words"sv) {
+            options.minus_word_probability = stod(value);
+        } else if (name == "stop-words"sv) {
+            options.stop_word_count = stoull(value);
+        } else if (name == "duplicates"sv) {
+            options.duplicate_fraction = stod(value);
+        } else if (name == "remove"sv) {
+            options.remove_fraction = stod(value);
+        } else if (name == "process-queries-runs"sv) {
+            options.process_queries_repetitions = stoull(value);
+        } else if (name == "seed"sv) {
+            options.seed = stoull(value);
+        } else if (name == "output"sv) {
+            options.output = value;
+        } else {
+            throw invalid_argument("Unknown option "s + string(name));
+        }
+    }
+    if (options.vocabulary_size == 0) {
+        throw invalid_argument("Vocabulary must not be empty"s);
+    }
+    if (options.stop_word_count >= options.vocabulary_size) {
+        throw invalid_argument("All words of the vocabulary would be stop words"s);
+    }
+    return options;
+}
+
+int main(int argc, char* argv[]) {
+    for (int i = 1; i < argc; ++i) {
+        if (argv[i] == "--help"sv || argv[i] == "-h"sv) {
+            PrintUsage(cout);
+            return 0;
+        }
+    }
+
+    BenchmarkOptions options;
+    try {
+        options = ParseOptions(argc, argv);
+    } catch (const exception& e) {
+        cerr << e.what() << endl;
+        PrintUsage(cerr);
+        return 1;
+    }
+
+    const Workload workload = GenerateWorkload(options);
+    const vector<BenchmarkResult> results = RunBenchmarks(options, workload);
+
+    if (options.output.empty()) {
+        WriteJson(cout, options, results);
+        return 0;
+    }
+    ofstream out(options.output);
+    if (!out) {
+        cerr << "Cannot open "s << options.output << endl;
+        return 1;
+    }
+    WriteJson(out, options, results);
+}
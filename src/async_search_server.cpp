@@ -0,0 +1,153 @@
+#include <algorithm>
+#include <execution>
+#include <memory>
+#include <numeric>
+#include <tuple>
+#include <utility>
+
+#include "async_search_server.h"
+
+using namespace std;
+
+AsyncSearchServer::AsyncSearchServer(const SearchServer& search_server, MicroBatchOptions options)
+    : AsyncSearchServer(search_server, GetDefaultThreadPool(), options) {
+}
+
+AsyncSearchServer::AsyncSearchServer(const SearchServer& search_server, ThreadPool& pool, MicroBatchOptions options)
+    : search_server_(search_server)
+    , pool_(pool)
+    , options_(options) {
+    if (options_.max_batch_size == 0) {
+        throw invalid_argument("max_batch_size must be positive"s);
+    }
+    collector_ = thread([this] {
+        CollectBatches();
+    });
+}
+
+AsyncSearchServer::~AsyncSearchServer() {
+    {
+        lock_guard guard(mutex_);
+        is_stopping_ = true;
+    }
+    arrived_.notify_all();
+    collector_.join();
+
+    unique_lock lock(mutex_);
+    finished_.wait(lock, [this] {
+        return running_count_ == 0;
+    });
+}
+
+future<vector<Document>> AsyncSearchServer::Submit(string raw_query, DocumentStatus status) {
+    Request request{{}, status, {}, Clock::now()};
+    auto result = request.promise.get_future();
+    try {
+        search_server_.ParseQuery(raw_query, request.query);
+    } catch (...) {
+        request.promise.set_exception(current_exception());
+        return result;
+    }
+
+    lock_guard guard(mutex_);
+    pending_.push_back(move(request));
+    // сборщик спит до срока пакета, будить его нужно только для нового пакета или полного
+    if (pending_.size() == 1 || pending_.size() == options_.max_batch_size) {
+        arrived_.notify_one();
+    }
+    return result;
+}
+
+void AsyncSearchServer::CollectBatches() {
+    unique_lock lock(mutex_);
+    while (true) {
+        arrived_.wait(lock, [this] {
+            return is_stopping_ || !pending_.empty();
+        });
+        if (pending_.empty()) {
+            return;
+        }
+        // оставшиеся от прошлого пакета запросы уже ждали, поэтому срок считается от самого старого
+        arrived_.wait_until(lock, pending_.front().enqueue_time + options_.max_delay, [this] {
+            return is_stopping_ || pending_.size() >= options_.max_batch_size;
+        });
+
+        const size_t batch_size = min(pending_.size(), options_.max_batch_size);
+        vector<Request> batch(make_move_iterator(pending_.begin()), make_move_iterator(pending_.begin() + batch_size));
+        pending_.erase(pending_.begin(), pending_.begin() + batch_size);
+
+        lock.unlock();
+        ExecuteBatch(move(batch));
+        lock.lock();
+    }
+}
+
+void AsyncSearchServer::ExecuteBatch(vector<Request> batch) {
+    // Запросы с одинаковым ключом (статус и наборы слов, как в ResultCache) стоят рядом и образуют группу,
+    // у группы один поиск. Группы делятся на куски по числу потоков пула, каждый кусок — одна задача
+    struct SharedBatch {
+        vector<Request> requests;
+        vector<size_t> order;
+        // группа i — order[group_firsts[i], group_firsts[i + 1])
+        vector<size_t> group_firsts;
+    };
+    auto shared_batch = make_shared<SharedBatch>();
+    auto& requests = shared_batch->requests;
+    auto& order = shared_batch->order;
+    auto& group_firsts = shared_batch->group_firsts;
+    requests = move(batch);
+    order.resize(requests.size());
+    iota(order.begin(), order.end(), 0);
+    const auto request_key = [&requests](size_t index) {
+        const Request& request = requests[index];
+        return tie(request.status, request.query.plus_terms, request.query.minus_terms);
+    };
+    sort(order.begin(), order.end(), [&request_key](size_t lhs, size_t rhs) {
+        return request_key(lhs) < request_key(rhs);
+    });
+    for (size_t i = 0; i < order.size(); ++i) {
+        if (i == 0 || request_key(order[i]) != request_key(order[i - 1])) {
+            group_firsts.push_back(i);
+        }
+    }
+    const size_t group_count = group_firsts.size();
+    group_firsts.push_back(order.size());
+
+    const size_t chunk_count = min(group_count, max<size_t>(pool_.GetThreadCount(), 1));
+    vector<ThreadPool::Task> tasks;
+    tasks.reserve(chunk_count);
+    for (size_t chunk = 0; chunk < chunk_count; ++chunk) {
+        const size_t first_group = chunk * group_count / chunk_count;
+        const size_t last_group = (chunk + 1) * group_count / chunk_count;
+        tasks.push_back([this, shared_batch, first_group, last_group] {
+            auto& requests = shared_batch->requests;
+            const auto& order = shared_batch->order;
+            const auto& group_firsts = shared_batch->group_firsts;
+            for (size_t group = first_group; group < last_group; ++group) {
+                const auto first = order.begin() + group_firsts[group];
+                const auto last = order.begin() + group_firsts[group + 1];
+                const Request& request = requests[*first];
+                try {
+                    const auto documents = search_server_.FindTopDocuments(execution::seq, request.query, request.status, ResultWindow{});
+                    for (auto it = first; it != last; ++it) {
+                        requests[*it].promise.set_value(documents);
+                    }
+                } catch (...) {
+                    for (auto it = first; it != last; ++it) {
+                        requests[*it].promise.set_exception(current_exception());
+                    }
+                }
+            }
+            lock_guard guard(mutex_);
+            if (--running_count_ == 0) {
+                finished_.notify_all();
+            }
+        });
+    }
+
+    {
+        lock_guard guard(mutex_);
+        running_count_ += tasks.size();
+    }
+    pool_.Post(move(tasks));
+}
@@ -0,0 +1,64 @@
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <future>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "document.h"
+#include "search_server.h"
+#include "thread_pool.h"
+
+struct MicroBatchOptions {
+    // сколько самый старый запрос пакета ждёт попутчиков
+    std::chrono::microseconds max_delay{200};
+    // пакет отправляется сразу, как только наберёт столько запросов
+    size_t max_batch_size = 64;
+};
+
+// Асинхронный вход в SearchServer: запросы из разных потоков собираются в пакеты (не дольше max_delay
+// или до max_batch_size запросов) и выполняются пакетом в пуле потоков. Запрос разбирается в отправившем
+// его потоке; запросы пакета с одинаковыми наборами плюс- и минус-слов и статусом выполняются один раз,
+// результат получает каждый. Сервер не должен меняться, пока жив AsyncSearchServer;
+// деструктор выполняет уже принятые запросы и дожидается их
+class AsyncSearchServer {
+public:
+    explicit AsyncSearchServer(const SearchServer& search_server, MicroBatchOptions options = {});
+    AsyncSearchServer(const SearchServer& search_server, ThreadPool& pool, MicroBatchOptions options = {});
+    AsyncSearchServer(const AsyncSearchServer&) = delete;
+    AsyncSearchServer& operator=(const AsyncSearchServer&) = delete;
+    ~AsyncSearchServer();
+
+    // ошибка запроса (например, std::invalid_argument) передаётся через future
+    std::future<std::vector<Document>> Submit(std::string raw_query, DocumentStatus status = DocumentStatus::ACTUAL);
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    struct Request {
+        SearchServer::Query query;
+        DocumentStatus status;
+        std::promise<std::vector<Document>> promise;
+        Clock::time_point enqueue_time;
+    };
+
+    const SearchServer& search_server_;
+    ThreadPool& pool_;
+    const MicroBatchOptions options_;
+
+    std::mutex mutex_;
+    std::condition_variable arrived_;
+    // запросы в порядке поступления; срок пакета отсчитывается от первого из них
+    std::vector<Request> pending_;
+    // задачи, отправленные в пул и ещё не завершённые
+    size_t running_count_ = 0;
+    std::condition_variable finished_;
+    bool is_stopping_ = false;
+    std::thread collector_;
+
+    void CollectBatches();
+    void ExecuteBatch(std::vector<Request> batch);
+};
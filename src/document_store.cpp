@@ -0,0 +1,99 @@
+#include <stdexcept>
+#include <string>
+#include <utility>
+
+#include "document_store.h"
+
+using namespace std;
+
+DocumentStore::IdIterator::IdIterator(SlotMap::const_iterator it)
+    : it_(it) {
+}
+
+const int& DocumentStore::IdIterator::operator*() const {
+    return it_->first;
+}
+
+DocumentStore::IdIterator& DocumentStore::IdIterator::operator++() {
+    ++it_;
+    return *this;
+}
+
+DocumentStore::IdIterator DocumentStore::IdIterator::operator++(int) {
+    IdIterator old = *this;
+    ++it_;
+    return old;
+}
+
+bool DocumentStore::IdIterator::operator==(const IdIterator& other) const {
+    return it_ == other.it_;
+}
+
+bool DocumentStore::IdIterator::operator!=(const IdIterator& other) const {
+    return it_ != other.it_;
+}
+
+DocumentStore::DocumentStore(vector<int> ids, vector<DocumentStatus> statuses, vector<int> ratings)
+    : ids_(move(ids))
+    , statuses_(move(statuses))
+    , ratings_(move(ratings)) {
+    for (DocumentSlot slot = 0; slot < ids_.size(); ++slot) {
+        if (ids_[slot] < 0) {
+            free_slots_.push_back(slot);
+        } else if (!slots_->emplace(ids_[slot], slot).second) {
+            throw invalid_argument("Duplicate document id "s + to_string(ids_[slot]));
+        }
+    }
+}
+
+DocumentSlot DocumentStore::Add(int document_id, DocumentStatus status, int rating) {
+    DocumentSlot slot;
+    if (free_slots_.empty()) {
+        slot = static_cast<DocumentSlot>(ids_.size());
+        ids_.push_back(document_id);
+        statuses_.push_back(status);
+        ratings_.push_back(rating);
+    } else {
+        slot = free_slots_.back();
+        free_slots_.pop_back();
+        ids_[slot] = document_id;
+        statuses_[slot] = status;
+        ratings_[slot] = rating;
+    }
+    slots_->emplace(document_id, slot);
+    return slot;
+}
+
+void DocumentStore::Remove(int document_id) {
+    const auto it = slots_->find(document_id);
+    if (it == slots_->end()) {
+        return;
+    }
+    ids_[it->second] = -1;
+    free_slots_.push_back(it->second);
+    slots_->erase(it);
+}
+
+bool DocumentStore::Contains(int document_id) const {
+    return slots_->count(document_id) > 0;
+}
+
+DocumentSlot DocumentStore::GetSlot(int document_id) const {
+    return slots_->at(document_id);
+}
+
+size_t DocumentStore::Size() const {
+    return slots_->size();
+}
+
+size_t DocumentStore::SlotCount() const {
+    return ids_.size();
+}
+
+DocumentStore::IdIterator DocumentStore::begin() const {
+    return IdIterator(slots_->begin());
+}
+
+DocumentStore::IdIterator DocumentStore::end() const {
+    return IdIterator(slots_->end());
+}
@@ -0,0 +1,89 @@
+#pragma once
+
+#include <cstdint>
+#include <iterator>
+#include <map>
+#include <vector>
+
+#include "document.h"
+#include "pooled_container.h"
+
+// внутренний номер документа: индекс в столбцах DocumentStore
+using DocumentSlot = uint32_t;
+
+// Атрибуты документов в плотных столбцах по слотам. Слоты удалённых документов
+// переиспользуются, отображение внешних id в слоты упорядочено по id, его узлы лежат в пуле хранилища
+class DocumentStore {
+public:
+    using SlotMap = std::pmr::map<int, DocumentSlot>;
+
+    class IdIterator {
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = int;
+        using difference_type = std::ptrdiff_t;
+        using pointer = const int*;
+        using reference = const int&;
+
+        IdIterator() = default;
+        explicit IdIterator(SlotMap::const_iterator it);
+
+        const int& operator*() const;
+        IdIterator& operator++();
+        IdIterator operator++(int);
+        bool operator==(const IdIterator& other) const;
+        bool operator!=(const IdIterator& other) const;
+
+    private:
+        SlotMap::const_iterator it_;
+    };
+
+    DocumentStore() = default;
+    // восстанавливает хранилище по столбцам; свободные слоты отмечены id, равным -1.
+    // Бросает std::invalid_argument, если один id занимает несколько слотов
+    DocumentStore(std::vector<int> ids, std::vector<DocumentStatus> statuses, std::vector<int> ratings);
+
+    DocumentSlot Add(int document_id, DocumentStatus status, int rating);
+    void Remove(int document_id);
+
+    bool Contains(int document_id) const;
+    // бросает std::out_of_range для неизвестного id
+    DocumentSlot GetSlot(int document_id) const;
+
+    int GetId(DocumentSlot slot) const {
+        return ids_[slot];
+    }
+    DocumentStatus GetStatus(DocumentSlot slot) const {
+        return statuses_[slot];
+    }
+    void SetStatus(DocumentSlot slot, DocumentStatus status) {
+        statuses_[slot] = status;
+    }
+    int GetRating(DocumentSlot slot) const {
+        return ratings_[slot];
+    }
+
+    const std::vector<int>& Ids() const {
+        return ids_;
+    }
+    const std::vector<DocumentStatus>& Statuses() const {
+        return statuses_;
+    }
+    const std::vector<int>& Ratings() const {
+        return ratings_;
+    }
+
+    size_t Size() const;
+    // число слотов, включая свободные
+    size_t SlotCount() const;
+
+    IdIterator begin() const;
+    IdIterator end() const;
+
+private:
+    PooledContainer<SlotMap> slots_;
+    std::vector<int> ids_;
+    std::vector<DocumentStatus> statuses_;
+    std::vector<int> ratings_;
+    std::vector<DocumentSlot> free_slots_;
+};
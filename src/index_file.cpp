@@ -0,0 +1,147 @@
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <stdexcept>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "index_file.h"
+
+using namespace std;
+
+MappedFile::MappedFile(const string& path) {
+    const int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        throw runtime_error("Can't open index file "s + path);
+    }
+    struct stat file_stat;
+    if (fstat(fd, &file_stat) != 0) {
+        close(fd);
+        throw runtime_error("Can't read index file "s + path);
+    }
+    size_ = static_cast<size_t>(file_stat.st_size);
+    if (size_ > 0) {
+        void* data = mmap(nullptr, size_, PROT_READ, MAP_SHARED, fd, 0);
+        if (data == MAP_FAILED) {
+            close(fd);
+            throw runtime_error("Can't map index file "s + path);
+        }
+        data_ = static_cast<const char*>(data);
+    }
+    close(fd);
+}
+
+MappedFile::~MappedFile() {
+    if (data_ != nullptr) {
+        munmap(const_cast<char*>(data_), size_);
+    }
+}
+
+const char* MappedFile::Data() const {
+    return data_;
+}
+
+size_t MappedFile::Size() const {
+    return size_;
+}
+
+IndexFileWriter::IndexFileWriter(const string& path)
+    : path_(path)
+    , temp_path_(path + ".tmp"s)
+    , out_(temp_path_, ios::binary | ios::trunc) {
+    if (!out_) {
+        throw runtime_error("Can't create index file "s + temp_path_);
+    }
+    const uint32_t version[] = {INDEX_FILE_VERSION, 0};
+    WriteRaw(INDEX_FILE_MAGIC, sizeof(INDEX_FILE_MAGIC));
+    WriteRaw(version, sizeof(version));
+}
+
+void IndexFileWriter::WriteStrings(const vector<string_view>& strings) {
+    vector<uint64_t> offsets;
+    offsets.reserve(strings.size() + 1);
+    offsets.push_back(0);
+    for (const string_view str : strings) {
+        offsets.push_back(offsets.back() + str.size());
+    }
+    WriteArray(offsets);
+
+    BeginArray<char>(offsets.back());
+    for (const string_view str : strings) {
+        WriteElements(str.data(), str.size());
+    }
+    EndArray();
+}
+
+void IndexFileWriter::EndArray() {
+    const char padding[8] = {};
+    WriteRaw(padding, (8 - size_ % 8) % 8);
+}
+
+IndexFileWriter::~IndexFileWriter() {
+    if (!finished_) {
+        out_.close();
+        remove(temp_path_.c_str());
+    }
+}
+
+void IndexFileWriter::Finish() {
+    out_.close();
+    if (!out_) {
+        throw runtime_error("Can't write index file "s + temp_path_);
+    }
+    // данные должны попасть на диск раньше переименования, иначе после сбоя path может оказаться неполным
+    const int fd = open(temp_path_.c_str(), O_RDONLY);
+    const bool synced = fd >= 0 && fsync(fd) == 0;
+    if (fd >= 0) {
+        close(fd);
+    }
+    if (!synced) {
+        throw runtime_error("Can't write index file "s + temp_path_);
+    }
+    if (rename(temp_path_.c_str(), path_.c_str()) != 0) {
+        throw runtime_error("Can't replace index file "s + path_);
+    }
+    finished_ = true;
+}
+
+void IndexFileWriter::WriteRaw(const void* data, size_t size) {
+    out_.write(static_cast<const char*>(data), size);
+    size_ += size;
+}
+
+IndexFileReader::IndexFileReader(const string& path)
+    : file_(path) {
+    const char* magic = ReadRaw(sizeof(INDEX_FILE_MAGIC));
+    uint32_t version;
+    memcpy(&version, ReadRaw(2 * sizeof(uint32_t)), sizeof(version));
+    if (memcmp(magic, INDEX_FILE_MAGIC, sizeof(INDEX_FILE_MAGIC)) != 0 || version != INDEX_FILE_VERSION) {
+        throw runtime_error("Unsupported index file "s + path);
+    }
+}
+
+vector<string_view> IndexFileReader::ReadStrings() {
+    const auto offsets = ReadArray<uint64_t>();
+    const auto chars = ReadArray<char>();
+    if (offsets.size == 0 || offsets[offsets.size - 1] != chars.size || !is_sorted(offsets.begin(), offsets.end())) {
+        throw runtime_error("Index file is corrupted"s);
+    }
+    vector<string_view> strings;
+    strings.reserve(offsets.size - 1);
+    for (size_t i = 0; i + 1 < offsets.size; ++i) {
+        strings.emplace_back(chars.data + offsets[i], offsets[i + 1] - offsets[i]);
+    }
+    return strings;
+}
+
+const char* IndexFileReader::ReadRaw(size_t size) {
+    if (size > file_.Size() - pos_) {
+        throw runtime_error("Index file is corrupted"s);
+    }
+    const char* data = file_.Data() + pos_;
+    pos_ += size;
+    return data;
+}
@@ -0,0 +1,136 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+// Формат файла индекса: заголовок, затем массивы подряд. Каждый массив — число элементов,
+// размер элемента и сами элементы, выровненные на 8 байт, поэтому после отображения файла
+// в память массивы можно читать на месте
+const char INDEX_FILE_MAGIC[8] = {'S', 'R', 'C', 'H', 'I', 'D', 'X', '\0'};
+const uint32_t INDEX_FILE_VERSION = 1;
+
+// Файл, отображённый в память только для чтения
+class MappedFile {
+public:
+    explicit MappedFile(const std::string& path);
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+    ~MappedFile();
+
+    const char* Data() const;
+    size_t Size() const;
+
+private:
+    const char* data_ = nullptr;
+    size_t size_ = 0;
+};
+
+// Пишет во временный файл path + ".tmp" и только в Finish подменяет им path, поэтому сбой посреди записи
+// не портит прежний файл. Если Finish не вызван, временный файл удаляется
+class IndexFileWriter {
+public:
+    explicit IndexFileWriter(const std::string& path);
+    IndexFileWriter(const IndexFileWriter&) = delete;
+    IndexFileWriter& operator=(const IndexFileWriter&) = delete;
+    ~IndexFileWriter();
+
+    template <typename T>
+    void WriteArray(const T* values, size_t count) {
+        BeginArray<T>(count);
+        WriteElements(values, count);
+        EndArray();
+    }
+
+    template <typename T>
+    void WriteArray(const std::vector<T>& values) {
+        WriteArray(values.data(), values.size());
+    }
+
+    // массив можно записывать по частям: BeginArray, несколько WriteElements на count элементов в сумме, EndArray
+    template <typename T>
+    void BeginArray(size_t count);
+    template <typename T>
+    void WriteElements(const T* values, size_t count);
+    void EndArray();
+
+    // смещения начала строк (на одно больше, чем строк) и их символы подряд
+    void WriteStrings(const std::vector<std::string_view>& strings);
+
+    // сбрасывает данные на диск и переименовывает временный файл в path;
+    // бросает std::runtime_error, если запись не удалась
+    void Finish();
+
+private:
+    std::string path_;
+    std::string temp_path_;
+    std::ofstream out_;
+    bool finished_ = false;
+    uint64_t size_ = 0;
+
+    void WriteRaw(const void* data, size_t size);
+};
+
+class IndexFileReader {
+public:
+    // бросает std::runtime_error, если файл не открывается или это не индекс поддерживаемой версии
+    explicit IndexFileReader(const std::string& path);
+
+    template <typename T>
+    struct ArrayView {
+        const T* data;
+        size_t size;
+
+        const T* begin() const {
+            return data;
+        }
+        const T* end() const {
+            return data + size;
+        }
+        const T& operator[](size_t index) const {
+            return data[index];
+        }
+    };
+
+    // данные не копируются, а указывают в отображённый файл
+    template <typename T>
+    ArrayView<T> ReadArray();
+
+    std::vector<std::string_view> ReadStrings();
+
+private:
+    MappedFile file_;
+    size_t pos_ = 0;
+
+    const char* ReadRaw(size_t size);
+};
+
+template <typename T>
+void IndexFileWriter::BeginArray(size_t count) {
+    static_assert(std::is_trivially_copyable_v<T>);
+    const uint64_t header[] = {count, sizeof(T)};
+    WriteRaw(header, sizeof(header));
+}
+
+template <typename T>
+void IndexFileWriter::WriteElements(const T* values, size_t count) {
+    WriteRaw(values, count * sizeof(T));
+}
+
+template <typename T>
+IndexFileReader::ArrayView<T> IndexFileReader::ReadArray() {
+    static_assert(std::is_trivially_copyable_v<T>);
+    const uint64_t* header = reinterpret_cast<const uint64_t*>(ReadRaw(2 * sizeof(uint64_t)));
+    if (header[1] != sizeof(T) || header[0] > (file_.Size() - pos_) / sizeof(T)) {
+        throw std::runtime_error("Index file is corrupted");
+    }
+    const size_t count = header[0];
+    const T* data = reinterpret_cast<const T*>(ReadRaw(count * sizeof(T)));
+    ReadRaw(std::min((8 - pos_ % 8) % 8, file_.Size() - pos_));
+    return {data, count};
+}
@@ -0,0 +1,200 @@
+#include <charconv>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <execution>
+#include <fstream>
+#include <mutex>
+#include <optional>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#include "ingest_documents.h"
+
+using namespace std;
+
+namespace {
+
+// пока добавляется один пакет, следующий уже прочитан и ждёт в очереди, а третий читается
+const size_t MAX_READY_CHUNKS = 1;
+
+struct Chunk {
+    // строки пакета подряд; тексты документов — string_view на этот буфер.
+    // В отличие от короткой строки, vector при перемещении пакета сохраняет адрес данных, и ссылки остаются валидными
+    vector<char> buffer;
+    vector<DocumentToAdd> documents;
+};
+
+// Очередь прочитанных пакетов ограниченной длины: читатель ждёт, пока добавление не освободит место
+class ChunkQueue {
+public:
+    void Push(Chunk chunk) {
+        unique_lock lock(mutex_);
+        not_full_.wait(lock, [this] {
+            return chunks_.size() < MAX_READY_CHUNKS || cancelled_;
+        });
+        if (!cancelled_) {
+            chunks_.push_back(move(chunk));
+            not_empty_.notify_one();
+        }
+    }
+
+    // пустой результат — данные закончились
+    optional<Chunk> Pop() {
+        unique_lock lock(mutex_);
+        not_empty_.wait(lock, [this] {
+            return !chunks_.empty() || finished_;
+        });
+        if (chunks_.empty()) {
+            if (error_) {
+                rethrow_exception(error_);
+            }
+            return nullopt;
+        }
+        Chunk chunk = move(chunks_.front());
+        chunks_.pop_front();
+        not_full_.notify_one();
+        return chunk;
+    }
+
+    void Finish(exception_ptr error = nullptr) {
+        lock_guard guard(mutex_);
+        finished_ = true;
+        error_ = error;
+        not_empty_.notify_one();
+    }
+
+    void Cancel() {
+        lock_guard guard(mutex_);
+        cancelled_ = true;
+        not_full_.notify_one();
+    }
+
+    bool IsCancelled() {
+        lock_guard guard(mutex_);
+        return cancelled_;
+    }
+
+private:
+    mutex mutex_;
+    condition_variable not_full_;
+    condition_variable not_empty_;
+    deque<Chunk> chunks_;
+    bool finished_ = false;
+    bool cancelled_ = false;
+    exception_ptr error_;
+};
+
+int ParseInt(string_view text, size_t line_number) {
+    int value = 0;
+    const auto [end, error] = from_chars(text.data(), text.data() + text.size(), value);
+    if (error != errc() || end != text.data() + text.size()) {
+        throw invalid_argument("Invalid number in line "s + to_string(line_number));
+    }
+    return value;
+}
+
+string_view NextField(string_view& line, size_t line_number) {
+    const size_t tab = line.find('\t');
+    if (tab == line.npos) {
+        throw invalid_argument("Too few fields in line "s + to_string(line_number));
+    }
+    const string_view field = line.substr(0, tab);
+    line.remove_prefix(tab + 1);
+    return field;
+}
+
+DocumentToAdd ParseDocumentLine(string_view line, size_t line_number) {
+    DocumentToAdd document;
+    document.id = ParseInt(NextField(line, line_number), line_number);
+    const int status = ParseInt(NextField(line, line_number), line_number);
+    if (status < static_cast<int>(DocumentStatus::ACTUAL) || status > static_cast<int>(DocumentStatus::REMOVED)) {
+        throw invalid_argument("Invalid status in line "s + to_string(line_number));
+    }
+    document.status = static_cast<DocumentStatus>(status);
+    ForEachWord(NextField(line, line_number), [&document, line_number](string_view rating) {
+        document.ratings.push_back(ParseInt(rating, line_number));
+    });
+    document.text = line;
+    return document;
+}
+
+// Читает до chunk_size строк; пустой пакет — конец входа
+Chunk ReadChunk(istream& input, size_t chunk_size, size_t& line_number) {
+    struct LinePosition {
+        size_t offset;
+        size_t size;
+        size_t number;
+    };
+
+    Chunk chunk;
+    vector<LinePosition> lines;
+    string line;
+    while (lines.size() < chunk_size && getline(input, line)) {
+        ++line_number;
+        if (!line.empty() && line.back() == '\r') {
+            line.pop_back();
+        }
+        if (line.empty()) {
+            continue;
+        }
+        lines.push_back({chunk.buffer.size(), line.size(), line_number});
+        chunk.buffer.insert(chunk.buffer.end(), line.begin(), line.end());
+    }
+    if (input.bad()) {
+        throw runtime_error("Can't read documents"s);
+    }
+
+    // буфер больше не растёт, теперь на него можно ссылаться
+    chunk.documents.reserve(lines.size());
+    for (const LinePosition& position : lines) {
+        const string_view text(chunk.buffer.data() + position.offset, position.size);
+        chunk.documents.push_back(ParseDocumentLine(text, position.number));
+    }
+    return chunk;
+}
+
+}  // namespace
+
+size_t IngestDocuments(SearchServer& search_server, istream& input, size_t chunk_size) {
+    chunk_size = max<size_t>(chunk_size, 1);
+    ChunkQueue queue;
+    thread reader([&queue, &input, chunk_size] {
+        try {
+            size_t line_number = 0;
+            while (!queue.IsCancelled()) {
+                Chunk chunk = ReadChunk(input, chunk_size, line_number);
+                if (chunk.documents.empty()) {
+                    break;
+                }
+                queue.Push(move(chunk));
+            }
+            queue.Finish();
+        } catch (...) {
+            queue.Finish(current_exception());
+        }
+    });
+
+    size_t document_count = 0;
+    try {
+        while (const auto chunk = queue.Pop()) {
+            search_server.AddDocuments(execution::par, chunk->documents);
+            document_count += chunk->documents.size();
+        }
+    } catch (...) {
+        queue.Cancel();
+        reader.join();
+        throw;
+    }
+    reader.join();
+    return document_count;
+}
+
+size_t IngestDocumentsFromFile(SearchServer& search_server, const string& path, size_t chunk_size) {
+    ifstream input(path);
+    if (!input) {
+        throw runtime_error("Can't open "s + path);
+    }
+    return IngestDocuments(search_server, input, chunk_size);
+}
@@ -0,0 +1,16 @@
+#pragma once
+
+#include <istream>
+#include <string>
+
+#include "search_server.h"
+
+// Документы по одному в строке: id, статус (число), рейтинги через пробел и текст, разделённые табуляцией:
+// "17\t0\t5 -3 8\tпушистый кот"
+//
+// Чтение следующих строк идёт в отдельном потоке параллельно с разбором и добавлением уже прочитанных.
+// В памяти одновременно не больше трёх пакетов по chunk_size документов, независимо от размера входа.
+// Некорректная строка или документ приводят к std::invalid_argument; документы из предыдущих пакетов
+// к этому моменту уже добавлены. Возвращает число добавленных документов
+size_t IngestDocuments(SearchServer& search_server, std::istream& input, size_t chunk_size = 10'000);
+size_t IngestDocumentsFromFile(SearchServer& search_server, const std::string& path, size_t chunk_size = 10'000);
@@ -4,12 +4,13 @@
 #include <iostream>
 #include <string_view>
 
-#define PROFILE_CONCAT_INTERNAL(X, Y) X##Y
-#define PROFILE_CONCAT(X, Y) PROFILE_CONCAT_INTERNAL(X, Y)
+#include "profiler.h"
+
 #define UNIQUE_VAR_NAME_PROFILE PROFILE_CONCAT(profileGuard, __LINE__)
 #define LOG_DURATION(x) LogDuration UNIQUE_VAR_NAME_PROFILE(x)
 #define LOG_DURATION_STREAM(x, out) LogDuration UNIQUE_VAR_NAME_PROFILE(x, out)
 
+// Печатает время жизни объекта в миллисекундах; с SEARCH_SERVER_PROFILING ещё и записывает участок в профилировщик
 class LogDuration {
 public:
     // заменим имя типа std::chrono::steady_clock
@@ -18,6 +19,10 @@ public:
 
     LogDuration(const std::string_view& id, std::ostream& out = std::cerr)
         : id_(id)
+#ifdef SEARCH_SERVER_PROFILING
+        , span_name_(id)
+        , span_(span_name_)
+#endif
         , start_time_(Clock::now())
         , out_(out) {
     }
@@ -33,6 +38,10 @@ public:
 
 private:
     const std::string id_;
+#ifdef SEARCH_SERVER_PROFILING
+    const ProfileSpanName span_name_;
+    const ProfileSpan span_;
+#endif
     const Clock::time_point start_time_;
     std::ostream& out_;
 };
\ No newline at end of file
@@ -1,11 +1,15 @@
 #include "search_server.h"
+#include "snapshot_search_server.h"
 
 #include "log_duration.h"
 
+#include <atomic>
 #include <execution>
+#include <fstream>
 #include <iostream>
 #include <random>
 #include <string>
+#include <thread>
 #include <vector>
 
 using namespace std;
@@ -65,8 +69,58 @@ void Test(string_view mark, const SearchServer& search_server, const vector<stri
     cout << total_relevance << endl;
 }
 
+void TestParse(string_view mark, const vector<string>& queries) {
+    LOG_DURATION(mark);
+    size_t word_count = 0;
+    for (int i = 0; i < 100; ++i) {
+        for (const string_view query : queries) {
+            ForEachWord(query, [&word_count](string_view) {
+                ++word_count;
+            });
+        }
+    }
+    cout << word_count << endl;
+}
+
 #define TEST(policy) Test(#policy, search_server, queries, execution::policy)
 
+// читатели непрерывно ищут, пока писатель добавляет и удаляет документы
+void TestConcurrentUpdates(string_view mark, const string& stop_words, const vector<string>& documents, const vector<string>& queries) {
+    LOG_DURATION(mark);
+    SnapshotSearchServer search_server{SearchServer(stop_words)};
+    atomic_bool done = false;
+    atomic_int query_count = 0;
+
+    vector<thread> readers;
+    for (int i = 0; i < 3; ++i) {
+        readers.emplace_back([&search_server, &done, &query_count, &queries] {
+            while (!done) {
+                for (const string_view query : queries) {
+                    search_server.FindTopDocuments(query);
+                    ++query_count;
+                }
+            }
+        });
+    }
+
+    const int batch_size = 100;
+    for (int first = 0; first < static_cast<int>(documents.size()); first += batch_size) {
+        search_server.Update([&documents, first](SearchServer& server) {
+            for (int id = first; id < min(first + batch_size, static_cast<int>(documents.size())); ++id) {
+                server.AddDocument(id, documents[id], DocumentStatus::ACTUAL, {1, 2, 3});
+            }
+            if (first >= batch_size) {
+                server.RemoveDocument(first - batch_size);
+            }
+        });
+    }
+    done = true;
+    for (thread& reader : readers) {
+        reader.join();
+    }
+    cout << search_server.GetDocumentCount() << " documents, "s << query_count << " queries"s << endl;
+}
+
 int main() {
     mt19937 generator;
 
@@ -80,6 +134,15 @@ int main() {
 
     const auto queries = GenerateQueries(generator, dictionary, 100, 70);
 
+    TestParse("parse x100"sv, queries);
     TEST(seq);
     TEST(par);
+
+    TestConcurrentUpdates("concurrent updates"sv, dictionary[0], vector(documents.begin(), documents.begin() + 2'000), vector(queries.begin(), queries.begin() + 10));
+
+#ifdef SEARCH_SERVER_PROFILING
+    Profiler::WriteSummary(cerr);
+    ofstream trace("search_server_trace.json"s);
+    Profiler::WriteChromeTrace(trace);
+#endif
 }
\ No newline at end of file
@@ -0,0 +1,65 @@
+#pragma once
+
+#include <memory>
+#include <memory_resource>
+
+// Узловой pmr-контейнер (std::pmr::map, std::pmr::unordered_map и т. п.) со своим пулом памяти:
+// узлы берутся из пула блоками, а не по одному из кучи, и освобождаются вместе с пулом.
+// Копия получает свой пул, перемещение передаёт пул вместе с узлами и ничего не выделяет.
+// Перемещённый объект остаётся пустым контейнером
+template <typename Container>
+class PooledContainer {
+public:
+    PooledContainer() = default;
+
+    PooledContainer(const PooledContainer& other)
+        : state_(other.state_ ? std::make_unique<State>(other.state_->container) : nullptr) {
+    }
+
+    PooledContainer& operator=(const PooledContainer& other) {
+        if (this != &other) {
+            state_ = other.state_ ? std::make_unique<State>(other.state_->container) : nullptr;
+        }
+        return *this;
+    }
+
+    PooledContainer(PooledContainer&&) noexcept = default;
+    PooledContainer& operator=(PooledContainer&&) noexcept = default;
+
+    Container& operator*() {
+        if (!state_) {
+            state_ = std::make_unique<State>();
+        }
+        return state_->container;
+    }
+
+    const Container& operator*() const {
+        static const Container empty;
+        return state_ ? state_->container : empty;
+    }
+
+    Container* operator->() {
+        return &**this;
+    }
+
+    const Container* operator->() const {
+        return &**this;
+    }
+
+private:
+    struct State {
+        State()
+            : container(&pool) {
+        }
+
+        explicit State(const Container& other)
+            : container(other, &pool) {
+        }
+
+        std::pmr::unsynchronized_pool_resource pool;
+        Container container;
+    };
+
+    // создаётся при первом изменении, поэтому пустой контейнер ничего не выделяет
+    std::unique_ptr<State> state_;
+};
@@ -0,0 +1,159 @@
+#include <algorithm>
+#include <cmath>
+
+#include "posting_list.h"
+
+using namespace std;
+
+namespace {
+
+// массивы части сжимаются, когда удалённые вхождения составляют больше 1/REMOVED_SHARE_LIMIT её длины:
+// сжатие за линейное время приходится на линейное число удалений
+const size_t REMOVED_SHARE_LIMIT = 4;
+
+}  // namespace
+
+PostingList::PostingList(vector<DocumentSlot> slots, vector<double> term_freqs, const vector<DocumentStatus>& statuses) {
+    for (size_t i = 0; i < slots.size(); ++i) {
+        Part& part = GetPart(statuses[slots[i]]);
+        part.slots.push_back(slots[i]);
+        part.term_freqs.push_back(term_freqs[i]);
+        part.max_term_freq = max(part.max_term_freq, term_freqs[i]);
+    }
+    size_ = slots.size();
+}
+
+void PostingList::Add(DocumentSlot slot, double term_freq, DocumentStatus status) {
+    inverse_document_freq_.Reset();
+    Part& part = GetPart(status);
+    const size_t position = part.FindPosition(slot);
+    if (position < part.slots.size() && part.slots[position] == slot) {
+        if (IsRemoved(part.term_freqs[position])) {
+            // слот освободился и достался новому документу, отмеченное вхождение оживает
+            --part.removed_count;
+            ++size_;
+        }
+        part.term_freqs[position] += term_freq;
+        part.max_term_freq = max(part.max_term_freq, part.term_freqs[position]);
+        return;
+    }
+    part.Insert(position, slot, term_freq);
+    ++size_;
+}
+
+void PostingList::Remove(DocumentSlot slot, DocumentStatus status) {
+    Part& part = GetPart(status);
+    const size_t position = part.FindPosition(slot);
+    if (position == part.slots.size() || part.slots[position] != slot || IsRemoved(part.term_freqs[position])) {
+        return;
+    }
+    inverse_document_freq_.Reset();
+    part.Erase(position);
+    --size_;
+}
+
+void PostingList::ChangeStatus(DocumentSlot slot, DocumentStatus old_status, DocumentStatus new_status) {
+    Part& old_part = GetPart(old_status);
+    const size_t position = old_part.FindPosition(slot);
+    if (old_status == new_status || position == old_part.slots.size() || old_part.slots[position] != slot
+        || IsRemoved(old_part.term_freqs[position])) {
+        return;
+    }
+    const double term_freq = old_part.term_freqs[position];
+    old_part.Erase(position);
+
+    Part& new_part = GetPart(new_status);
+    const size_t new_position = new_part.FindPosition(slot);
+    if (new_position < new_part.slots.size() && new_part.slots[new_position] == slot) {
+        // здесь может лежать только отмеченное вхождение: документ есть не больше чем у одного статуса
+        --new_part.removed_count;
+        new_part.term_freqs[new_position] = term_freq;
+        new_part.max_term_freq = max(new_part.max_term_freq, term_freq);
+        return;
+    }
+    new_part.Insert(new_position, slot, term_freq);
+}
+
+bool PostingList::Contains(DocumentSlot slot, DocumentStatus status) const {
+    const Part& part = GetPart(status);
+    const size_t position = part.FindPosition(slot);
+    return position < part.slots.size() && part.slots[position] == slot && !IsRemoved(part.term_freqs[position]);
+}
+
+size_t PostingList::Size() const {
+    return size_;
+}
+
+bool PostingList::Empty() const {
+    return size_ == 0;
+}
+
+const vector<DocumentSlot>& PostingList::Slots(DocumentStatus status) const {
+    return GetPart(status).slots;
+}
+
+const vector<double>& PostingList::TermFreqs(DocumentStatus status) const {
+    return GetPart(status).term_freqs;
+}
+
+double PostingList::MaxTermFreq(DocumentStatus status) const {
+    return GetPart(status).max_term_freq;
+}
+
+double PostingList::GetInverseDocumentFreq(size_t document_count) const {
+    if (inverse_document_freq_.document_count.load(memory_order_acquire) != document_count) {
+        inverse_document_freq_.value.store(log(document_count * 1.0 / size_), memory_order_relaxed);
+        inverse_document_freq_.document_count.store(document_count, memory_order_release);
+    }
+    return inverse_document_freq_.value.load(memory_order_relaxed);
+}
+
+PostingList::Part& PostingList::GetPart(DocumentStatus status) {
+    return parts_[static_cast<size_t>(status)];
+}
+
+const PostingList::Part& PostingList::GetPart(DocumentStatus status) const {
+    return parts_[static_cast<size_t>(status)];
+}
+
+size_t PostingList::Part::FindPosition(DocumentSlot slot) const {
+    // новые документы обычно получают слот в конце, тогда их место сразу за концом массива
+    if (slots.empty() || slots.back() < slot) {
+        return slots.size();
+    }
+    return lower_bound(slots.begin(), slots.end(), slot) - slots.begin();
+}
+
+void PostingList::Part::Insert(size_t position, DocumentSlot slot, double term_freq) {
+    slots.insert(slots.begin() + position, slot);
+    term_freqs.insert(term_freqs.begin() + position, term_freq);
+    max_term_freq = max(max_term_freq, term_freq);
+}
+
+void PostingList::Part::Erase(size_t position) {
+    term_freqs[position] = REMOVED_TERM_FREQ;
+    ++removed_count;
+    if (removed_count * REMOVED_SHARE_LIMIT > slots.size()) {
+        Compact();
+    }
+}
+
+void PostingList::Part::Compact() {
+    size_t kept = 0;
+    max_term_freq = 0.0;
+    for (size_t i = 0; i < slots.size(); ++i) {
+        if (!IsRemoved(term_freqs[i])) {
+            slots[kept] = slots[i];
+            term_freqs[kept] = term_freqs[i];
+            max_term_freq = max(max_term_freq, term_freqs[i]);
+            ++kept;
+        }
+    }
+    slots.resize(kept);
+    term_freqs.resize(kept);
+    removed_count = 0;
+    if (slots.size() * 4 < slots.capacity()) {
+        slots.shrink_to_fit();
+        term_freqs.shrink_to_fit();
+    }
+}
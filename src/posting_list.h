@@ -0,0 +1,93 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <vector>
+
+#include "document.h"
+#include "document_store.h"
+
+const size_t DOCUMENT_STATUS_COUNT = 4;
+
+// Список вхождений слова: слоты документов и частоты слова в них, в отдельных массивах.
+// У каждого статуса документа свои массивы, слоты в них идут по возрастанию, поэтому поиск по одному статусу
+// обходит только его вхождения, а новый документ любого статуса обычно просто дописывается в конец.
+// Удаление только отмечает вхождение (частота REMOVED_TERM_FREQ), а массивы статуса сжимаются за один проход,
+// когда отмеченных наберётся заметная доля, так что удаление документа не сдвигает хвосты списков
+class PostingList {
+public:
+    static constexpr double REMOVED_TERM_FREQ = 0.0;
+
+    PostingList() = default;
+    // statuses — статусы документов по слотам; вхождения документов одного статуса идут по возрастанию слота
+    PostingList(std::vector<DocumentSlot> slots, std::vector<double> term_freqs, const std::vector<DocumentStatus>& statuses);
+
+    void Add(DocumentSlot slot, double term_freq, DocumentStatus status);
+    void Remove(DocumentSlot slot, DocumentStatus status);
+    // переносит вхождение документа к вхождениям нового статуса; число вхождений и IDF не меняются
+    void ChangeStatus(DocumentSlot slot, DocumentStatus old_status, DocumentStatus new_status);
+
+    bool Contains(DocumentSlot slot, DocumentStatus status) const;
+    // число вхождений, не считая удалённых
+    size_t Size() const;
+    bool Empty() const;
+
+    // вхождения документов со статусом status, включая удалённые: их частота равна REMOVED_TERM_FREQ (см. IsRemoved)
+    const std::vector<DocumentSlot>& Slots(DocumentStatus status) const;
+    const std::vector<double>& TermFreqs(DocumentStatus status) const;
+    static bool IsRemoved(double term_freq) {
+        return term_freq == REMOVED_TERM_FREQ;
+    }
+    // Не меньше наибольшей частоты слова среди документов со статусом status, для верхней оценки вклада слова
+    // в релевантность. После удалений оценка может быть завышена до ближайшего сжатия
+    double MaxTermFreq(DocumentStatus status) const;
+
+    // IDF слова в индексе из document_count документов: log(document_count / Size()).
+    // Значение запоминается для последнего document_count и пересчитывается только после изменения индекса;
+    // параллельные запросы к неизменному индексу пишут одно и то же значение
+    double GetInverseDocumentFreq(size_t document_count) const;
+
+private:
+    // копия начинает с пустого значения
+    struct CachedInverseDocumentFreq {
+        static constexpr uint64_t NO_DOCUMENT_COUNT = UINT64_MAX;
+
+        CachedInverseDocumentFreq() = default;
+        CachedInverseDocumentFreq(const CachedInverseDocumentFreq&) noexcept {
+        }
+        CachedInverseDocumentFreq& operator=(const CachedInverseDocumentFreq&) noexcept {
+            Reset();
+            return *this;
+        }
+
+        void Reset() {
+            document_count.store(NO_DOCUMENT_COUNT, std::memory_order_relaxed);
+        }
+
+        std::atomic<uint64_t> document_count{NO_DOCUMENT_COUNT};
+        std::atomic<double> value{0.0};
+    };
+
+    // вхождения документов одного статуса
+    struct Part {
+        std::vector<DocumentSlot> slots;
+        std::vector<double> term_freqs;
+        size_t removed_count = 0;
+        double max_term_freq = 0.0;
+
+        size_t FindPosition(DocumentSlot slot) const;
+        // position — место слота по FindPosition
+        void Insert(size_t position, DocumentSlot slot, double term_freq);
+        // отмечает вхождение удалённым и сжимает массивы, если удалённых стало много
+        void Erase(size_t position);
+        void Compact();
+    };
+
+    std::array<Part, DOCUMENT_STATUS_COUNT> parts_;
+    size_t size_ = 0;
+    mutable CachedInverseDocumentFreq inverse_document_freq_;
+
+    Part& GetPart(DocumentStatus status);
+    const Part& GetPart(DocumentStatus status) const;
+};
@@ -1,36 +1,156 @@
 #include <algorithm>
-#include <numeric>
-#include <execution>
+#include <iterator>
 
 #include "process_queries.h"
 
 using namespace std;
 
-vector<vector<Document>> ProcessQueries(const SearchServer& search_server, const vector<string>& queries) {
+vector<vector<Document>> ProcessQueries(const SearchServer& search_server, const vector<string>& queries, ThreadPool& pool) {
     vector<vector<Document>> result(queries.size());
-    transform(
-        execution::par,
-        queries.begin(), queries.end(),
-        result.begin(),
-        [&search_server](const string& raw_query) {
-            return search_server.FindTopDocuments(raw_query);
-        }
-    );
+    pool.ParallelFor(queries.size(), [&search_server, &queries, &result](size_t i) {
+        result[i] = search_server.FindTopDocuments(queries[i]);
+    });
     return result;
 }
 
+vector<vector<Document>> ProcessQueries(const SearchServer& search_server, const vector<string>& queries) {
+    return ProcessQueries(search_server, queries, GetDefaultThreadPool());
+}
+
+FlatQueryResults ProcessQueriesFlat(const SearchServer& search_server, const vector<string>& queries, ThreadPool& pool) {
+    // выдача запроса не длиннее MAX_RESULT_DOCUMENT_COUNT, так что у каждого запроса своя часть массива
+    FlatQueryResults results;
+    results.documents.resize(queries.size() * MAX_RESULT_DOCUMENT_COUNT);
+    vector<size_t> document_counts(queries.size());
+    pool.ParallelFor(queries.size(), [&search_server, &queries, &results, &document_counts](size_t i) {
+        const auto documents = search_server.FindTopDocuments(queries[i]);
+        copy(documents.begin(), documents.end(), results.documents.begin() + i * MAX_RESULT_DOCUMENT_COUNT);
+        document_counts[i] = documents.size();
+    });
+
+    results.offsets.reserve(queries.size() + 1);
+    results.offsets.push_back(0);
+    for (size_t i = 0; i < queries.size(); ++i) {
+        // части сдвигаются только влево, поэтому перенос вперёд по массиву ничего не затирает
+        const size_t from = i * MAX_RESULT_DOCUMENT_COUNT;
+        if (from != results.offsets.back()) {
+            const auto first = results.documents.begin() + from;
+            move(first, first + document_counts[i], results.documents.begin() + results.offsets.back());
+        }
+        results.offsets.push_back(results.offsets.back() + document_counts[i]);
+    }
+    results.documents.resize(results.offsets.back());
+    return results;
+}
+
+FlatQueryResults ProcessQueriesFlat(const SearchServer& search_server, const vector<string>& queries) {
+    return ProcessQueriesFlat(search_server, queries, GetDefaultThreadPool());
+}
+
+vector<Document> ProcessQueriesJoined(const SearchServer& search_server, const vector<string>& queries, ThreadPool& pool) {
+    return ProcessQueriesFlat(search_server, queries, pool).documents;
+}
+
 vector<Document> ProcessQueriesJoined(const SearchServer& search_server, const vector<string>& queries) {
-    vector<Document> documents = transform_reduce(
-        execution::par,
-        queries.begin(), queries.end(),
-        vector<Document>(),
-        [](vector<Document> acc, const vector<Document>& documents) {
-            copy(documents.begin(), documents.end(), back_inserter<vector<Document>>(acc));
-            return acc;
-        },
-        [&search_server](const string& raw_query) {
-            return search_server.FindTopDocuments(raw_query);
+    return ProcessQueriesJoined(search_server, queries, GetDefaultThreadPool());
+}
+
+QueryResultStream::QueryResultStream(const SearchServer& search_server, vector<string> queries, ThreadPool& pool)
+    : queries_(move(queries))
+    , results_(queries_.size())
+    , errors_(queries_.size())
+    , is_ready_(queries_.size(), 0)
+    , running_count_(queries_.size()) {
+    vector<ThreadPool::Task> tasks;
+    tasks.reserve(queries_.size());
+    for (size_t i = 0; i < queries_.size(); ++i) {
+        tasks.push_back([this, &search_server, i] {
+            vector<Document> documents;
+            exception_ptr error;
+            try {
+                documents = search_server.FindTopDocuments(queries_[i]);
+            } catch (...) {
+                error = current_exception();
+            }
+            lock_guard guard(mutex_);
+            results_[i] = move(documents);
+            errors_[i] = error;
+            is_ready_[i] = 1;
+            --running_count_;
+            ready_.notify_all();
+        });
+    }
+    pool.Post(move(tasks));
+}
+
+QueryResultStream::QueryResultStream(const SearchServer& search_server, vector<string> queries)
+    : QueryResultStream(search_server, move(queries), GetDefaultThreadPool()) {
+}
+
+QueryResultStream::~QueryResultStream() {
+    unique_lock lock(mutex_);
+    ready_.wait(lock, [this] {
+        return running_count_ == 0;
+    });
+}
+
+optional<Document> QueryResultStream::Next() {
+    unique_lock lock(mutex_);
+    while (query_index_ < results_.size()) {
+        ready_.wait(lock, [this] {
+            return is_ready_[query_index_] != 0;
+        });
+        if (errors_[query_index_]) {
+            const exception_ptr error = errors_[query_index_];
+            ++query_index_;
+            document_index_ = 0;
+            rethrow_exception(error);
+        }
+        auto& documents = results_[query_index_];
+        if (document_index_ < documents.size()) {
+            return documents[document_index_++];
         }
-    );
-    return documents;
-}
\ No newline at end of file
+        // выданная выдача больше не нужна
+        vector<Document>().swap(documents);
+        ++query_index_;
+        document_index_ = 0;
+    }
+    return nullopt;
+}
+
+QueryResultStream::Iterator QueryResultStream::begin() {
+    return Iterator(this);
+}
+
+QueryResultStream::Iterator QueryResultStream::end() {
+    return Iterator();
+}
+
+QueryResultStream::Iterator::Iterator(QueryResultStream* stream)
+    : stream_(stream) {
+    ++*this;
+}
+
+const Document& QueryResultStream::Iterator::operator*() const {
+    return *document_;
+}
+
+const Document* QueryResultStream::Iterator::operator->() const {
+    return &*document_;
+}
+
+QueryResultStream::Iterator& QueryResultStream::Iterator::operator++() {
+    document_ = stream_->Next();
+    if (!document_) {
+        stream_ = nullptr;
+    }
+    return *this;
+}
+
+bool QueryResultStream::Iterator::operator==(const Iterator& other) const {
+    return stream_ == other.stream_;
+}
+
+bool QueryResultStream::Iterator::operator!=(const Iterator& other) const {
+    return !(*this == other);
+}
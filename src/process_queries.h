@@ -1,11 +1,89 @@
 #pragma once
 
+#include <condition_variable>
+#include <exception>
+#include <iterator>
+#include <mutex>
+#include <optional>
 #include <vector>
 #include <string>
 
 #include "document.h"
 #include "search_server.h"
+#include "thread_pool.h"
 
+// Запросы выполняются в пуле pool, каждый запрос — отдельная задача. Без pool используется GetDefaultThreadPool()
+std::vector<std::vector<Document>> ProcessQueries(const SearchServer& search_server, const std::vector<std::string>& queries, ThreadPool& pool);
 std::vector<std::vector<Document>> ProcessQueries(const SearchServer& search_server, const std::vector<std::string>& queries);
 
-std::vector<Document> ProcessQueriesJoined(const SearchServer& search_server, const std::vector<std::string>& queries);
\ No newline at end of file
+// Выдачи пакета запросов в одном массиве: документы запроса i лежат в documents[offsets[i], offsets[i + 1])
+struct FlatQueryResults {
+    std::vector<Document> documents;
+    std::vector<size_t> offsets;
+};
+
+// Каждый запрос пишет выдачу в свою часть заранее выделенного массива, затем части сдвигаются встык
+FlatQueryResults ProcessQueriesFlat(const SearchServer& search_server, const std::vector<std::string>& queries, ThreadPool& pool);
+FlatQueryResults ProcessQueriesFlat(const SearchServer& search_server, const std::vector<std::string>& queries);
+
+std::vector<Document> ProcessQueriesJoined(const SearchServer& search_server, const std::vector<std::string>& queries, ThreadPool& pool);
+std::vector<Document> ProcessQueriesJoined(const SearchServer& search_server, const std::vector<std::string>& queries);
+
+// Выдаёт документы тех же запросов в том же порядке, что и ProcessQueriesJoined, но по мере готовности:
+// документы запроса доступны, как только выполнены он и все запросы перед ним.
+// Запросы начинают выполняться в pool сразу при создании; деструктор ждёт завершения уже начатых.
+// Ошибка запроса пробрасывается из Next, когда очередь доходит до него.
+// Поток хранит свою копию запросов, а сервер и пул берёт по ссылке: они должны пережить поток.
+// Читать поток из задачи того же пула нельзя: ожидание заняло бы поток, которому нужно выполнять запросы
+class QueryResultStream {
+public:
+    class Iterator {
+    public:
+        using iterator_category = std::input_iterator_tag;
+        using value_type = Document;
+        using difference_type = std::ptrdiff_t;
+        using pointer = const Document*;
+        using reference = const Document&;
+
+        Iterator() = default;
+        explicit Iterator(QueryResultStream* stream);
+
+        reference operator*() const;
+        pointer operator->() const;
+        Iterator& operator++();
+
+        bool operator==(const Iterator& other) const;
+        bool operator!=(const Iterator& other) const;
+
+    private:
+        QueryResultStream* stream_ = nullptr;
+        std::optional<Document> document_;
+    };
+
+    QueryResultStream(const SearchServer& search_server, std::vector<std::string> queries, ThreadPool& pool);
+    QueryResultStream(const SearchServer& search_server, std::vector<std::string> queries);
+    // временный сервер был бы разрушен раньше, чем задачи потока закончат с ним работать
+    QueryResultStream(SearchServer&& search_server, std::vector<std::string> queries, ThreadPool& pool) = delete;
+    QueryResultStream(SearchServer&& search_server, std::vector<std::string> queries) = delete;
+    QueryResultStream(const QueryResultStream&) = delete;
+    QueryResultStream& operator=(const QueryResultStream&) = delete;
+    ~QueryResultStream();
+
+    // следующий документ или std::nullopt, когда документы всех запросов выданы
+    std::optional<Document> Next();
+
+    Iterator begin();
+    Iterator end();
+
+private:
+    const std::vector<std::string> queries_;
+    std::mutex mutex_;
+    std::condition_variable ready_;
+    std::vector<std::vector<Document>> results_;
+    std::vector<std::exception_ptr> errors_;
+    std::vector<char> is_ready_;
+    size_t running_count_;
+    // позиция чтения
+    size_t query_index_ = 0;
+    size_t document_index_ = 0;
+};
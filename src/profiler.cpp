@@ -0,0 +1,308 @@
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cmath>
+#include <iomanip>
+#include <memory>
+#include <mutex>
+
+#include "profiler.h"
+
+using namespace std;
+
+namespace {
+
+const uint32_t NO_SPAN_NAME = UINT32_MAX;
+
+// длительности: по 4 корзины на степень двойки наносекунд, до 2^40 нс
+const size_t DURATION_SUB_BINS = 4;
+const size_t DURATION_BIN_COUNT = 40 * DURATION_SUB_BINS;
+
+size_t GetDurationBin(uint64_t nanoseconds) {
+    if (nanoseconds < DURATION_SUB_BINS) {
+        return nanoseconds;
+    }
+    const size_t exponent = 63 - __builtin_clzll(nanoseconds);
+    const size_t sub_bin = (nanoseconds >> (exponent - 2)) & (DURATION_SUB_BINS - 1);
+    return min(exponent * DURATION_SUB_BINS + sub_bin, DURATION_BIN_COUNT - 1);
+}
+
+uint64_t GetDurationBinUpperBound(size_t bin) {
+    if (bin < DURATION_SUB_BINS) {
+        return bin;
+    }
+    const size_t exponent = bin / DURATION_SUB_BINS;
+    const uint64_t sub_bin = bin % DURATION_SUB_BINS;
+    return ((DURATION_SUB_BINS + sub_bin + 1) << (exponent - 2)) - 1;
+}
+
+int64_t GetTime() {
+    return chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+struct TraceEvent {
+    uint32_t name_id;
+    uint32_t depth;
+    int64_t start_time;
+    int64_t duration;
+};
+
+// Счётчики меняет только поток-владелец буфера, атомарны они ради чтения сводки из других потоков.
+// Поэтому вместо fetch_add хватает обычных чтения и записи, без блокировки шины
+void AddToCounter(atomic<uint64_t>& counter, uint64_t value) {
+    counter.store(counter.load(memory_order_relaxed) + value, memory_order_relaxed);
+}
+
+struct SpanHistogram {
+    atomic<uint64_t> count{0};
+    atomic<uint64_t> total{0};
+    atomic<uint64_t> max{0};
+    array<atomic<uint64_t>, DURATION_BIN_COUNT> bins{};
+};
+
+struct ThreadBuffer {
+    explicit ThreadBuffer(size_t index)
+        : index(index)
+        , events(make_unique<TraceEvent[]>(Profiler::MAX_TRACE_EVENTS_PER_THREAD)) {
+    }
+
+    // номер буфера служит номером потока в трассе
+    const size_t index;
+    // глубина вложенности открытых участков потока
+    uint32_t depth = 0;
+    unique_ptr<TraceEvent[]> events;
+    // события [0, event_count) записаны полностью
+    atomic<size_t> event_count{0};
+    atomic<uint64_t> dropped_event_count{0};
+    array<SpanHistogram, Profiler::MAX_SPAN_NAME_COUNT> histograms;
+};
+
+// Буферы не удаляются: после завершения потока данные остаются доступны, а буфер достаётся следующему новому потоку
+struct Registry {
+    mutex access;
+    vector<string> names;
+    vector<unique_ptr<ThreadBuffer>> buffers;
+    vector<ThreadBuffer*> free_buffers;
+    // начало отсчёта времени в трассе
+    int64_t start_time = GetTime();
+};
+
+Registry& GetRegistry() {
+    static Registry registry;
+    return registry;
+}
+
+ThreadBuffer* AcquireThreadBuffer() {
+    Registry& registry = GetRegistry();
+    lock_guard guard(registry.access);
+    if (!registry.free_buffers.empty()) {
+        ThreadBuffer* buffer = registry.free_buffers.back();
+        registry.free_buffers.pop_back();
+        return buffer;
+    }
+    registry.buffers.push_back(make_unique<ThreadBuffer>(registry.buffers.size()));
+    return registry.buffers.back().get();
+}
+
+struct ThreadBufferHolder {
+    ThreadBuffer* buffer = nullptr;
+
+    ~ThreadBufferHolder() {
+        if (buffer != nullptr) {
+            Registry& registry = GetRegistry();
+            lock_guard guard(registry.access);
+            registry.free_buffers.push_back(buffer);
+        }
+    }
+};
+
+thread_local ThreadBufferHolder thread_buffer;
+
+ThreadBuffer& GetThreadBuffer() {
+    if (thread_buffer.buffer == nullptr) {
+        thread_buffer.buffer = AcquireThreadBuffer();
+    }
+    return *thread_buffer.buffer;
+}
+
+void WriteJsonString(ostream& out, string_view text) {
+    out << '"';
+    for (const char c : text) {
+        if (c == '"' || c == '\\') {
+            out << '\\' << c;
+        } else if (static_cast<unsigned char>(c) < 0x20) {
+            out << "\\u"s << hex << setw(4) << setfill('0') << static_cast<int>(c) << dec << setfill(' ');
+        } else {
+            out << c;
+        }
+    }
+    out << '"';
+}
+
+}  // namespace
+
+ProfileSpanName::ProfileSpanName(string_view name)
+    : id_(Profiler::RegisterSpanName(name)) {
+}
+
+ProfileSpan::ProfileSpan(const ProfileSpanName& name)
+    : name_id_(name.GetId()) {
+    if (name_id_ != NO_SPAN_NAME) {
+        ++GetThreadBuffer().depth;
+    }
+    start_time_ = GetTime();
+}
+
+ProfileSpan::~ProfileSpan() {
+    const int64_t end_time = GetTime();
+    if (name_id_ == NO_SPAN_NAME) {
+        return;
+    }
+    ThreadBuffer& buffer = GetThreadBuffer();
+    --buffer.depth;
+    const auto duration = static_cast<uint64_t>(max<int64_t>(end_time - start_time_, 0));
+
+    SpanHistogram& histogram = buffer.histograms[name_id_];
+    AddToCounter(histogram.count, 1);
+    AddToCounter(histogram.total, duration);
+    if (duration > histogram.max.load(memory_order_relaxed)) {
+        histogram.max.store(duration, memory_order_relaxed);
+    }
+    AddToCounter(histogram.bins[GetDurationBin(duration)], 1);
+
+    const size_t event_count = buffer.event_count.load(memory_order_relaxed);
+    if (event_count == Profiler::MAX_TRACE_EVENTS_PER_THREAD) {
+        AddToCounter(buffer.dropped_event_count, 1);
+        return;
+    }
+    buffer.events[event_count] = {name_id_, buffer.depth, start_time_, static_cast<int64_t>(duration)};
+    buffer.event_count.store(event_count + 1, memory_order_release);
+}
+
+uint32_t Profiler::RegisterSpanName(string_view name) {
+    Registry& registry = GetRegistry();
+    lock_guard guard(registry.access);
+    const auto it = find(registry.names.begin(), registry.names.end(), name);
+    if (it != registry.names.end()) {
+        return static_cast<uint32_t>(it - registry.names.begin());
+    }
+    if (registry.names.size() == MAX_SPAN_NAME_COUNT) {
+        return NO_SPAN_NAME;
+    }
+    registry.names.emplace_back(name);
+    return static_cast<uint32_t>(registry.names.size() - 1);
+}
+
+vector<ProfileSpanStats> Profiler::GetSpanStats() {
+    Registry& registry = GetRegistry();
+    lock_guard guard(registry.access);
+    vector<ProfileSpanStats> result;
+    for (size_t name_id = 0; name_id < registry.names.size(); ++name_id) {
+        ProfileSpanStats stats;
+        stats.name = registry.names[name_id];
+        array<uint64_t, DURATION_BIN_COUNT> bins{};
+        uint64_t total = 0;
+        uint64_t max_duration = 0;
+        for (const auto& buffer : registry.buffers) {
+            const SpanHistogram& histogram = buffer->histograms[name_id];
+            stats.count += histogram.count.load(memory_order_relaxed);
+            total += histogram.total.load(memory_order_relaxed);
+            max_duration = max(max_duration, histogram.max.load(memory_order_relaxed));
+            for (size_t bin = 0; bin < DURATION_BIN_COUNT; ++bin) {
+                bins[bin] += histogram.bins[bin].load(memory_order_relaxed);
+            }
+        }
+        if (stats.count == 0) {
+            continue;
+        }
+        stats.total = chrono::nanoseconds(total);
+        stats.max = chrono::nanoseconds(max_duration);
+
+        // счётчики читаются не одновременно, поэтому сумма корзин может немного отличаться от count
+        uint64_t bin_total = 0;
+        for (const uint64_t count : bins) {
+            bin_total += count;
+        }
+        const auto get_quantile = [&bins, bin_total, max_duration](double quantile) {
+            const auto target = max<uint64_t>(static_cast<uint64_t>(ceil(quantile * bin_total)), 1);
+            uint64_t accumulated = 0;
+            for (size_t bin = 0; bin < DURATION_BIN_COUNT; ++bin) {
+                accumulated += bins[bin];
+                if (accumulated >= target) {
+                    return chrono::nanoseconds(min(GetDurationBinUpperBound(bin), max_duration));
+                }
+            }
+            return chrono::nanoseconds(max_duration);
+        };
+        stats.p50 = get_quantile(0.5);
+        stats.p90 = get_quantile(0.9);
+        stats.p99 = get_quantile(0.99);
+        result.push_back(move(stats));
+    }
+    return result;
+}
+
+void Profiler::WriteSummary(ostream& out) {
+    const auto to_microseconds = [](chrono::nanoseconds duration) {
+        return chrono::duration<double, micro>(duration).count();
+    };
+    out << "span: count, total ms, mean / p50 / p90 / p99 / max us"s << endl;
+    for (const ProfileSpanStats& stats : GetSpanStats()) {
+        out << stats.name << ": "s << stats.count << ", "s
+            << chrono::duration<double, milli>(stats.total).count() << ", "s
+            << to_microseconds(stats.total) / stats.count << " / "s
+            << to_microseconds(stats.p50) << " / "s
+            << to_microseconds(stats.p90) << " / "s
+            << to_microseconds(stats.p99) << " / "s
+            << to_microseconds(stats.max) << endl;
+    }
+}
+
+void Profiler::WriteChromeTrace(ostream& out) {
+    Registry& registry = GetRegistry();
+    lock_guard guard(registry.access);
+    const auto old_flags = out.flags();
+    const auto old_precision = out.precision();
+    out << fixed << setprecision(3);
+
+    out << "{\"traceEvents\":["s;
+    bool is_first = true;
+    uint64_t dropped_event_count = 0;
+    for (const auto& buffer : registry.buffers) {
+        const size_t event_count = buffer->event_count.load(memory_order_acquire);
+        dropped_event_count += buffer->dropped_event_count.load(memory_order_relaxed);
+        for (size_t i = 0; i < event_count; ++i) {
+            const TraceEvent& event = buffer->events[i];
+            out << (is_first ? "\n"s : ",\n"s) << "{\"name\":"s;
+            WriteJsonString(out, registry.names[event.name_id]);
+            // время в трассе — в микросекундах
+            out << ",\"ph\":\"X\",\"pid\":1,\"tid\":"s << buffer->index
+                << ",\"ts\":"s << (event.start_time - registry.start_time) / 1000.0
+                << ",\"dur\":"s << event.duration / 1000.0
+                << ",\"args\":{\"depth\":"s << event.depth << "}}"s;
+            is_first = false;
+        }
+    }
+    out << "\n],\"displayTimeUnit\":\"ns\",\"otherData\":{\"dropped_events\":"s << dropped_event_count << "}}"s << endl;
+
+    out.flags(old_flags);
+    out.precision(old_precision);
+}
+
+void Profiler::Reset() {
+    Registry& registry = GetRegistry();
+    lock_guard guard(registry.access);
+    for (const auto& buffer : registry.buffers) {
+        buffer->event_count.store(0, memory_order_relaxed);
+        buffer->dropped_event_count.store(0, memory_order_relaxed);
+        for (SpanHistogram& histogram : buffer->histograms) {
+            histogram.count.store(0, memory_order_relaxed);
+            histogram.total.store(0, memory_order_relaxed);
+            histogram.max.store(0, memory_order_relaxed);
+            for (auto& counter : histogram.bins) {
+                counter.store(0, memory_order_relaxed);
+            }
+        }
+    }
+    registry.start_time = GetTime();
+}
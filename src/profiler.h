@@ -0,0 +1,78 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Профилировщик участков кода. Участок — время жизни объекта ProfileSpan; вложенные участки образуют иерархию.
+// Каждый поток пишет участки в свой буфер без блокировок: запись трассы и гистограмма длительностей по имени участка.
+// Собирается только при определённом SEARCH_SERVER_PROFILING, иначе PROFILE_SCOPE не оставляет в коде ничего
+
+#define PROFILE_CONCAT_INTERNAL(X, Y) X##Y
+#define PROFILE_CONCAT(X, Y) PROFILE_CONCAT_INTERNAL(X, Y)
+
+#ifdef SEARCH_SERVER_PROFILING
+#define PROFILE_SCOPE(name)                                                                    \
+    static const ProfileSpanName PROFILE_CONCAT(profileSpanName, __LINE__)(name);              \
+    const ProfileSpan PROFILE_CONCAT(profileSpan, __LINE__)(PROFILE_CONCAT(profileSpanName, __LINE__))
+#else
+#define PROFILE_SCOPE(name) static_cast<void>(0)
+#endif
+
+// Имя участка, зарегистрированное в профилировщике. Обычно это статическая переменная в месте замера
+class ProfileSpanName {
+public:
+    explicit ProfileSpanName(std::string_view name);
+
+    uint32_t GetId() const {
+        return id_;
+    }
+
+private:
+    uint32_t id_;
+};
+
+class ProfileSpan {
+public:
+    explicit ProfileSpan(const ProfileSpanName& name);
+    ProfileSpan(const ProfileSpan&) = delete;
+    ProfileSpan& operator=(const ProfileSpan&) = delete;
+    ~ProfileSpan();
+
+private:
+    uint32_t name_id_;
+    int64_t start_time_;
+};
+
+// сводка по участкам одного имени во всех потоках; перцентили — верхние границы корзин гистограммы
+struct ProfileSpanStats {
+    std::string name;
+    uint64_t count = 0;
+    std::chrono::nanoseconds total{0};
+    std::chrono::nanoseconds max{0};
+    std::chrono::nanoseconds p50{0};
+    std::chrono::nanoseconds p90{0};
+    std::chrono::nanoseconds p99{0};
+};
+
+class Profiler {
+public:
+    // имена сверх лимита не регистрируются, и такие участки не записываются
+    static constexpr size_t MAX_SPAN_NAME_COUNT = 64;
+    // участки сверх лимита попадают только в гистограммы
+    static constexpr size_t MAX_TRACE_EVENTS_PER_THREAD = 1 << 16;
+
+    static uint32_t RegisterSpanName(std::string_view name);
+
+    // Чтение можно вести параллельно с замерами: видны все участки, завершённые до вызова
+    static std::vector<ProfileSpanStats> GetSpanStats();
+    static void WriteSummary(std::ostream& out);
+    // трасса в формате Chrome Trace Event (chrome://tracing, Perfetto)
+    static void WriteChromeTrace(std::ostream& out);
+
+    // очищает трассы и гистограммы; вызывать, когда ни в одном потоке нет открытых участков
+    static void Reset();
+};
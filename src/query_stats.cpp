@@ -0,0 +1,134 @@
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+#include "query_stats.h"
+
+using namespace std;
+
+namespace {
+
+// наименьшая корзина, на которой накопленная сумма достигает доли quantile от total
+template <typename Bins>
+size_t FindQuantileBin(const Bins& bins, uint64_t total, double quantile) {
+    const auto target = static_cast<uint64_t>(ceil(quantile * total));
+    uint64_t accumulated = 0;
+    for (size_t bin = 0; bin < bins.size(); ++bin) {
+        accumulated += bins[bin];
+        if (accumulated >= max<uint64_t>(target, 1)) {
+            return bin;
+        }
+    }
+    return bins.size() - 1;
+}
+
+}  // namespace
+
+QueryStats::QueryStats(chrono::nanoseconds bucket_width, size_t bucket_count)
+    : bucket_width_(bucket_width)
+    , bucket_count_(bucket_count) {
+    if (bucket_width_.count() <= 0 || bucket_count_ == 0) {
+        throw invalid_argument("Bucket width and count must be positive"s);
+    }
+    buckets_ = make_unique<Bucket[]>(bucket_count_);
+}
+
+void QueryStats::Record(chrono::nanoseconds latency, size_t result_count, Clock::time_point now) {
+    Bucket& bucket = AcquireBucket(GetInterval(now));
+    bucket.request_count.fetch_add(1, memory_order_relaxed);
+    if (result_count == 0) {
+        bucket.empty_result_count.fetch_add(1, memory_order_relaxed);
+    }
+    bucket.latency_bins[GetLatencyBin(latency)].fetch_add(1, memory_order_relaxed);
+    bucket.result_count_bins[min(result_count, RESULT_COUNT_BIN_COUNT - 1)].fetch_add(1, memory_order_relaxed);
+}
+
+QueryStatsSnapshot QueryStats::GetSnapshot(chrono::nanoseconds window, Clock::time_point now) const {
+    const uint64_t last_interval = GetInterval(now);
+    const uint64_t interval_count = clamp<uint64_t>((window.count() + bucket_width_.count() - 1) / bucket_width_.count(), 1, bucket_count_);
+
+    QueryStatsSnapshot snapshot;
+    snapshot.window = bucket_width_ * interval_count;
+    array<uint64_t, LATENCY_BIN_COUNT> latency_bins{};
+    array<uint64_t, RESULT_COUNT_BIN_COUNT> result_count_bins{};
+    for (size_t i = 0; i < bucket_count_; ++i) {
+        const Bucket& bucket = buckets_[i];
+        const uint64_t interval = bucket.interval.load(memory_order_acquire);
+        if (interval > last_interval || last_interval - interval >= interval_count) {
+            continue;
+        }
+        snapshot.request_count += bucket.request_count.load(memory_order_relaxed);
+        snapshot.empty_result_count += bucket.empty_result_count.load(memory_order_relaxed);
+        for (size_t bin = 0; bin < LATENCY_BIN_COUNT; ++bin) {
+            latency_bins[bin] += bucket.latency_bins[bin].load(memory_order_relaxed);
+        }
+        for (size_t bin = 0; bin < RESULT_COUNT_BIN_COUNT; ++bin) {
+            result_count_bins[bin] += bucket.result_count_bins[bin].load(memory_order_relaxed);
+        }
+    }
+    if (snapshot.request_count == 0) {
+        return snapshot;
+    }
+
+    snapshot.queries_per_second = snapshot.request_count / chrono::duration<double>(snapshot.window).count();
+    snapshot.empty_result_rate = static_cast<double>(snapshot.empty_result_count) / snapshot.request_count;
+    snapshot.latency_p50 = GetLatencyBinUpperBound(FindQuantileBin(latency_bins, snapshot.request_count, 0.5));
+    snapshot.latency_p90 = GetLatencyBinUpperBound(FindQuantileBin(latency_bins, snapshot.request_count, 0.9));
+    snapshot.latency_p99 = GetLatencyBinUpperBound(FindQuantileBin(latency_bins, snapshot.request_count, 0.99));
+    snapshot.result_count_p50 = FindQuantileBin(result_count_bins, snapshot.request_count, 0.5);
+    snapshot.result_count_p90 = FindQuantileBin(result_count_bins, snapshot.request_count, 0.9);
+    snapshot.result_count_p99 = FindQuantileBin(result_count_bins, snapshot.request_count, 0.99);
+    return snapshot;
+}
+
+uint64_t QueryStats::GetInterval(Clock::time_point time) const {
+    return time.time_since_epoch() / bucket_width_;
+}
+
+QueryStats::Bucket& QueryStats::AcquireBucket(uint64_t interval) {
+    Bucket& bucket = buckets_[interval % bucket_count_];
+    uint64_t current = bucket.interval.load(memory_order_acquire);
+    while (current != interval) {
+        if (current == RESETTING) {
+            current = bucket.interval.load(memory_order_acquire);
+            continue;
+        }
+        // поток задержался и пишет в уже сменившийся интервал: запрос учтётся в более новом
+        if (current != NO_INTERVAL && current > interval) {
+            break;
+        }
+        if (bucket.interval.compare_exchange_weak(current, RESETTING, memory_order_acquire)) {
+            bucket.request_count.store(0, memory_order_relaxed);
+            bucket.empty_result_count.store(0, memory_order_relaxed);
+            for (auto& counter : bucket.latency_bins) {
+                counter.store(0, memory_order_relaxed);
+            }
+            for (auto& counter : bucket.result_count_bins) {
+                counter.store(0, memory_order_relaxed);
+            }
+            bucket.interval.store(interval, memory_order_release);
+            break;
+        }
+    }
+    return bucket;
+}
+
+size_t QueryStats::GetLatencyBin(chrono::nanoseconds latency) {
+    const auto nanoseconds = static_cast<uint64_t>(max<int64_t>(latency.count(), 0));
+    if (nanoseconds < LATENCY_SUB_BINS) {
+        return nanoseconds;
+    }
+    // номер старшего бита и следующие за ним три бита
+    const size_t exponent = 63 - __builtin_clzll(nanoseconds);
+    const size_t sub_bin = (nanoseconds >> (exponent - 3)) & (LATENCY_SUB_BINS - 1);
+    return exponent * LATENCY_SUB_BINS + sub_bin;
+}
+
+chrono::nanoseconds QueryStats::GetLatencyBinUpperBound(size_t bin) {
+    if (bin < LATENCY_SUB_BINS) {
+        return chrono::nanoseconds(bin);
+    }
+    const size_t exponent = bin / LATENCY_SUB_BINS;
+    const uint64_t sub_bin = bin % LATENCY_SUB_BINS;
+    return chrono::nanoseconds(static_cast<int64_t>(((LATENCY_SUB_BINS + sub_bin + 1) << (exponent - 3)) - 1));
+}
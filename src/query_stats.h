@@ -0,0 +1,67 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+
+// Статистика запросов за скользящее окно
+struct QueryStatsSnapshot {
+    std::chrono::nanoseconds window{0};
+    uint64_t request_count = 0;
+    uint64_t empty_result_count = 0;
+    double queries_per_second = 0.0;
+    double empty_result_rate = 0.0;
+    // перцентили задержки: верхние границы корзин гистограммы, завышают не больше чем на 12.5%
+    std::chrono::nanoseconds latency_p50{0};
+    std::chrono::nanoseconds latency_p90{0};
+    std::chrono::nanoseconds latency_p99{0};
+    size_t result_count_p50 = 0;
+    size_t result_count_p90 = 0;
+    size_t result_count_p99 = 0;
+};
+
+// Сборщик статистики запросов, общий для всех потоков. Время делится на интервалы bucket_width,
+// счётчики последних bucket_count интервалов лежат в кольцевом буфере. Record не берёт блокировок:
+// это несколько атомарных инкрементов; только первый запрос в новом интервале обнуляет его счётчики
+class QueryStats {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    explicit QueryStats(std::chrono::nanoseconds bucket_width = std::chrono::seconds(1), size_t bucket_count = 60);
+
+    void Record(std::chrono::nanoseconds latency, size_t result_count, Clock::time_point now = Clock::now());
+
+    // Статистика за последние window (не больше bucket_width * bucket_count), включая текущий интервал
+    QueryStatsSnapshot GetSnapshot(std::chrono::nanoseconds window, Clock::time_point now = Clock::now()) const;
+
+private:
+    // задержки: по 8 корзин на каждую степень двойки наносекунд
+    static constexpr size_t LATENCY_SUB_BINS = 8;
+    static constexpr size_t LATENCY_BIN_COUNT = 64 * LATENCY_SUB_BINS;
+    // число документов в выдаче; в последней корзине — RESULT_COUNT_BIN_COUNT - 1 и больше
+    static constexpr size_t RESULT_COUNT_BIN_COUNT = 64;
+
+    struct Bucket {
+        // номер интервала, счётчики которого лежат в корзине; RESETTING — корзину обнуляют
+        std::atomic<uint64_t> interval{NO_INTERVAL};
+        std::atomic<uint64_t> request_count{0};
+        std::atomic<uint64_t> empty_result_count{0};
+        std::array<std::atomic<uint64_t>, LATENCY_BIN_COUNT> latency_bins{};
+        std::array<std::atomic<uint64_t>, RESULT_COUNT_BIN_COUNT> result_count_bins{};
+    };
+
+    static constexpr uint64_t NO_INTERVAL = UINT64_MAX;
+    static constexpr uint64_t RESETTING = UINT64_MAX - 1;
+
+    const std::chrono::nanoseconds bucket_width_;
+    const size_t bucket_count_;
+    std::unique_ptr<Bucket[]> buckets_;
+
+    uint64_t GetInterval(Clock::time_point time) const;
+    Bucket& AcquireBucket(uint64_t interval);
+
+    static size_t GetLatencyBin(std::chrono::nanoseconds latency);
+    static std::chrono::nanoseconds GetLatencyBinUpperBound(size_t bin);
+};
@@ -1,44 +1,164 @@
+#include <algorithm>
+#include <execution>
+#include <limits>
+#include <stdexcept>
+#include <unordered_map>
 #include <vector>
 
 #include "remove_duplicates.h"
 
 using namespace std;
 
+namespace {
+
+uint64_t MixHash(uint64_t value) {
+    // splitmix64
+    value += 0x9e3779b97f4a7c15ULL;
+    value = (value ^ (value >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    value = (value ^ (value >> 27)) * 0x94d049bb133111ebULL;
+    return value ^ (value >> 31);
+}
+
+using TermFreqs = vector<pair<TermId, double>>;
+
+// подпись множества слов документа: одинаковые множества дают одинаковую подпись
+uint64_t ComputeSignature(const TermFreqs& term_freqs) {
+    uint64_t signature = MixHash(term_freqs.size());
+    for (const auto& [term_id, _] : term_freqs) {
+        signature = MixHash(signature ^ term_id);
+    }
+    return signature;
+}
+
+bool HaveSameWords(const TermFreqs& lhs, const TermFreqs& rhs) {
+    return equal(lhs.begin(), lhs.end(), rhs.begin(), rhs.end(), [](const auto& l, const auto& r) {
+        return l.first == r.first;
+    });
+}
+
+double ComputeJaccard(const TermFreqs& lhs, const TermFreqs& rhs) {
+    if (lhs.empty() && rhs.empty()) {
+        return 1.0;
+    }
+    size_t common = 0;
+    for (auto l = lhs.begin(), r = rhs.begin(); l != lhs.end() && r != rhs.end();) {
+        if (l->first < r->first) {
+            ++l;
+        } else if (r->first < l->first) {
+            ++r;
+        } else {
+            ++common;
+            ++l;
+            ++r;
+        }
+    }
+    return static_cast<double>(common) / (lhs.size() + rhs.size() - common);
+}
+
+void RemoveFoundDuplicates(SearchServer& search_server, vector<int>& duplicates) {
+    sort(duplicates.begin(), duplicates.end());
+    for (const int duplicate_document_id : duplicates) {
+        cout << "Found duplicate document id "s << duplicate_document_id << endl;
+        search_server.RemoveDocument(duplicate_document_id);
+    }
+}
+
+}  // namespace
+
 void RemoveDuplicates(SearchServer& search_server) {
-    set<int> duplicates;
+    const vector<int> document_ids(search_server.begin(), search_server.end());
+    vector<uint64_t> signatures(document_ids.size());
+    transform(
+        execution::par,
+        document_ids.begin(), document_ids.end(),
+        signatures.begin(),
+        [&search_server](int document_id) {
+            return ComputeSignature(search_server.GetTermFrequencies(document_id));
+        }
+    );
+
+    // документы обходятся по возрастанию id, поэтому первый в группе с одинаковыми словами остаётся;
+    // в группе с одной подписью может оказаться несколько разных множеств слов
+    unordered_map<uint64_t, vector<int>> originals;
+    originals.reserve(document_ids.size());
+    vector<int> duplicates;
+    for (size_t i = 0; i < document_ids.size(); ++i) {
+        const auto& term_freqs = search_server.GetTermFrequencies(document_ids[i]);
+        auto& group = originals[signatures[i]];
+        const bool is_duplicate = any_of(group.begin(), group.end(), [&search_server, &term_freqs](int original_id) {
+            return HaveSameWords(search_server.GetTermFrequencies(original_id), term_freqs);
+        });
+        if (is_duplicate) {
+            duplicates.push_back(document_ids[i]);
+        } else {
+            group.push_back(document_ids[i]);
+        }
+    }
+
+    RemoveFoundDuplicates(search_server, duplicates);
+}
+
+void RemoveNearDuplicates(SearchServer& search_server, const NearDuplicateOptions& options) {
+    if (options.band_count == 0 || options.hash_count % options.band_count != 0) {
+        throw invalid_argument("hash_count must be a multiple of band_count"s);
+    }
+    const size_t rows = options.hash_count / options.band_count;
+    const vector<int> document_ids(search_server.begin(), search_server.end());
 
-    for (const int document_id : search_server) {
-        if (duplicates.count(document_id)) {
-            continue;
+    // MinHash: для каждой из hash_count хеш-функций минимальный хеш слов документа
+    vector<uint64_t> min_hashes(document_ids.size() * options.hash_count);
+    for_each(
+        execution::par,
+        document_ids.begin(), document_ids.end(),
+        [&](const int& document_id) {
+            const size_t index = &document_id - document_ids.data();
+            uint64_t* document_hashes = &min_hashes[index * options.hash_count];
+            fill(document_hashes, document_hashes + options.hash_count, numeric_limits<uint64_t>::max());
+            for (const auto& [term_id, _] : search_server.GetTermFrequencies(document_id)) {
+                const uint64_t term_hash = MixHash(term_id);
+                for (size_t h = 0; h < options.hash_count; ++h) {
+                    document_hashes[h] = min(document_hashes[h], MixHash(term_hash ^ (h * 0x9e3779b97f4a7c15ULL)));
+                }
+            }
         }
+    );
 
-        for (const int inner_document_id : search_server) {
-            if (document_id >= inner_document_id || duplicates.count(inner_document_id)) {
-                continue;
+    // LSH: документы, у которых совпала хотя бы одна полоса подписи, становятся кандидатами
+    vector<bool> is_duplicate(document_ids.size(), false);
+    vector<unordered_map<uint64_t, vector<size_t>>> buckets(options.band_count);
+    vector<int> duplicates;
+    for (size_t i = 0; i < document_ids.size(); ++i) {
+        vector<uint64_t> band_keys(options.band_count);
+        for (size_t band = 0; band < options.band_count; ++band) {
+            uint64_t key = MixHash(band);
+            for (size_t row = 0; row < rows; ++row) {
+                key = MixHash(key ^ min_hashes[i * options.hash_count + band * rows + row]);
             }
-            
-            const auto& words = search_server.GetWordFrequencies(document_id);
-            const auto& inner_words = search_server.GetWordFrequencies(inner_document_id);
-            
-            if (words.size() != inner_words.size()) {
+            band_keys[band] = key;
+        }
+
+        const auto& term_freqs = search_server.GetTermFrequencies(document_ids[i]);
+        for (size_t band = 0; band < options.band_count && !is_duplicate[i]; ++band) {
+            const auto it = buckets[band].find(band_keys[band]);
+            if (it == buckets[band].end()) {
                 continue;
             }
-
-            bool equal = true;
-            for (const auto& [word, _] : words) {
-                if (inner_words.count(word) == 0) {
-                    equal = false;
+            for (const size_t original : it->second) {
+                if (ComputeJaccard(search_server.GetTermFrequencies(document_ids[original]), term_freqs) >= options.similarity_threshold) {
+                    is_duplicate[i] = true;
                     break;
                 }
             }
-            if (equal) {
-                duplicates.insert(inner_document_id);
+        }
+
+        if (is_duplicate[i]) {
+            duplicates.push_back(document_ids[i]);
+        } else {
+            for (size_t band = 0; band < options.band_count; ++band) {
+                buckets[band][band_keys[band]].push_back(i);
             }
-        }    
+        }
     }
 
-    for (const int duplicate_document_id : duplicates) {
-        cout << "Found duplicate document id "s << duplicate_document_id << endl;
-        search_server.RemoveDocument(duplicate_document_id);
-    }
-}
\ No newline at end of file
+    RemoveFoundDuplicates(search_server, duplicates);
+}
@@ -3,3 +3,15 @@
 #include "search_server.h"
 
 void RemoveDuplicates(SearchServer& search_server);
+
+// Параметры поиска почти-дубликатов через MinHash и LSH: документы считаются дубликатами,
+// если коэффициент Жаккара их множеств слов не меньше similarity_threshold.
+// hash_count должен делиться на band_count; чем больше полос, тем меньше пропущенных пар и больше проверок
+struct NearDuplicateOptions {
+    double similarity_threshold = 0.8;
+    size_t hash_count = 128;
+    size_t band_count = 32;
+};
+
+// Удаляет документы, похожие на документ с меньшим id, который сам остаётся
+void RemoveNearDuplicates(SearchServer& search_server, const NearDuplicateOptions& options = {});
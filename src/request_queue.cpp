@@ -3,18 +3,27 @@
 using namespace std;
 
 RequestQueue::RequestQueue(const SearchServer& search_server)
-    : search_server_(search_server) {
+    : search_server_(search_server)
+    , own_stats_(make_unique<QueryStats>())
+    , stats_(*own_stats_) {
+}
+
+RequestQueue::RequestQueue(const SearchServer& search_server, QueryStats& stats)
+    : search_server_(search_server)
+    , stats_(stats) {
 }
 
 vector<Document> RequestQueue::AddFindRequest(const string& raw_query, DocumentStatus status) {
+    const auto start_time = QueryStats::Clock::now();
     const auto documents_ = search_server_.FindTopDocuments(raw_query, status);
-    UpdateRequests(documents_);
+    UpdateRequests(documents_, start_time);
     return documents_;
 }
 
 vector<Document> RequestQueue::AddFindRequest(const string& raw_query) {
+    const auto start_time = QueryStats::Clock::now();
     const auto documents_ = search_server_.FindTopDocuments(raw_query);
-    UpdateRequests(documents_);
+    UpdateRequests(documents_, start_time);
     return documents_;
 }
 
@@ -22,15 +31,25 @@ int RequestQueue::GetNoResultRequests() const {
     return not_found_count_;
 }
 
-void RequestQueue::UpdateRequests(const vector<Document>&  documents) {
-    requests_.push_back({documents});
-    if (documents.empty()) {
+const QueryStats& RequestQueue::GetStats() const {
+    return stats_;
+}
+
+void RequestQueue::UpdateRequests(const vector<Document>& documents, QueryStats::Clock::time_point start_time) {
+    const auto end_time = QueryStats::Clock::now();
+    stats_.Record(end_time - start_time, documents.size(), end_time);
+
+    // место самого старого запроса занимает новый
+    bool& is_empty_result = is_empty_result_[position_];
+    if (is_full_ && is_empty_result) {
+        --not_found_count_;
+    }
+    is_empty_result = documents.empty();
+    if (is_empty_result) {
         ++not_found_count_;
     }
-    if (requests_.size() > sec_in_day_) {
-        if (requests_.front().documents.empty()) {
-            --not_found_count_;
-        }
-        requests_.pop_back();
-    }   
-}
\ No newline at end of file
+    if (++position_ == sec_in_day_) {
+        position_ = 0;
+        is_full_ = true;
+    }
+}
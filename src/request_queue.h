@@ -1,15 +1,20 @@
 #pragma once 
 
+#include <array>
+#include <chrono>
+#include <memory>
 #include <vector>
 #include <string>
-#include <deque>
 
 #include "document.h"
+#include "query_stats.h"
 #include "search_server.h"
 
 class RequestQueue {
 public:
     explicit RequestQueue(const SearchServer& search_server);
+    // статистика пишется в stats, который могут делить очереди разных потоков
+    RequestQueue(const SearchServer& search_server, QueryStats& stats);
     
     // сделаем "обёртки" для всех методов поиска, чтобы сохранять результаты для нашей статистики
     template <typename DocumentPredicate>
@@ -17,23 +22,29 @@ public:
     std::vector<Document> AddFindRequest(const std::string& raw_query, DocumentStatus status);
     std::vector<Document> AddFindRequest(const std::string& raw_query);
 
+    // число запросов без результата среди последних sec_in_day_ запросов этой очереди
     int GetNoResultRequests() const;
+    const QueryStats& GetStats() const;
+
 private:
-    struct QueryResult {
-        std::vector<Document> documents;
-    };
-    std::deque<QueryResult> requests_;
     const static int sec_in_day_ = 1440;
+    // кольцевой буфер: был ли пуст результат каждого из последних sec_in_day_ запросов
+    std::array<bool, sec_in_day_> is_empty_result_{};
+    int position_ = 0;
+    bool is_full_ = false;
     int not_found_count_ = 0;
     const SearchServer& search_server_;
+    std::unique_ptr<QueryStats> own_stats_;
+    QueryStats& stats_;
     
-    void UpdateRequests(const std::vector<Document>&  documents);
+    void UpdateRequests(const std::vector<Document>& documents, QueryStats::Clock::time_point start_time);
 };
 
 // сделаем "обёртки" для всех методов поиска, чтобы сохранять результаты для нашей статистики
 template <typename DocumentPredicate>
 std::vector<Document> RequestQueue::AddFindRequest(const std::string& raw_query, DocumentPredicate document_predicate) {
+    const auto start_time = QueryStats::Clock::now();
     const auto documents_ = search_server_.FindTopDocuments(raw_query, document_predicate);
-    UpdateRequests(documents_);
+    UpdateRequests(documents_, start_time);
     return documents_;
-}
\ No newline at end of file
+}
@@ -0,0 +1,116 @@
+#include "result_cache.h"
+
+using namespace std;
+
+namespace {
+
+size_t CombineHash(size_t seed, size_t value) {
+    return seed ^ (value + 0x9e3779b97f4a7c15ULL + (seed << 6) + (seed >> 2));
+}
+
+}  // namespace
+
+bool operator==(const ResultCacheKey& lhs, const ResultCacheKey& rhs) {
+    return lhs.status == rhs.status && lhs.offset == rhs.offset && lhs.count == rhs.count
+        && lhs.plus_terms == rhs.plus_terms && lhs.minus_terms == rhs.minus_terms;
+}
+
+size_t ResultCacheKeyHasher::operator()(const ResultCacheKey& key) const {
+    size_t hash = CombineHash(static_cast<size_t>(key.status), key.plus_terms.size());
+    for (const TermId term_id : key.plus_terms) {
+        hash = CombineHash(hash, term_id);
+    }
+    // отделяем минус-слова от плюс-слов, чтобы "a -b" и "a b" не давали одну последовательность
+    hash = CombineHash(hash, key.minus_terms.size());
+    for (const TermId term_id : key.minus_terms) {
+        hash = CombineHash(hash, term_id);
+    }
+    hash = CombineHash(hash, key.offset);
+    return CombineHash(hash, key.count);
+}
+
+ResultCache::ResultCache(size_t capacity)
+    : capacity_(capacity) {
+}
+
+ResultCache::ResultCache(const ResultCache& other)
+    : capacity_(other.capacity_.load(memory_order_relaxed)) {
+}
+
+ResultCache& ResultCache::operator=(const ResultCache& other) {
+    if (this != &other) {
+        SetCapacity(other.capacity_.load(memory_order_relaxed));
+        lock_guard guard(mutex_);
+        entries_.clear();
+        index_.clear();
+    }
+    return *this;
+}
+
+bool ResultCache::IsEnabled() const {
+    return capacity_.load(memory_order_relaxed) > 0;
+}
+
+void ResultCache::SetCapacity(size_t capacity) {
+    lock_guard guard(mutex_);
+    capacity_.store(capacity, memory_order_relaxed);
+    EvictExcess();
+}
+
+optional<vector<Document>> ResultCache::Find(const ResultCacheKey& key, uint64_t generation) {
+    lock_guard guard(mutex_);
+    SwitchGeneration(generation);
+    const auto it = index_.find(key);
+    if (it == index_.end()) {
+        ++stats_.misses;
+        return nullopt;
+    }
+    ++stats_.hits;
+    entries_.splice(entries_.begin(), entries_, it->second);
+    return it->second->second;
+}
+
+void ResultCache::Insert(ResultCacheKey key, uint64_t generation, vector<Document> documents) {
+    lock_guard guard(mutex_);
+    SwitchGeneration(generation);
+    if (capacity_.load(memory_order_relaxed) == 0) {
+        return;
+    }
+    // тот же запрос мог успеть посчитать другой поток
+    const auto it = index_.find(key);
+    if (it != index_.end()) {
+        entries_.splice(entries_.begin(), entries_, it->second);
+        return;
+    }
+    entries_.emplace_front(move(key), move(documents));
+    index_.emplace(entries_.front().first, entries_.begin());
+    EvictExcess();
+}
+
+ResultCacheStats ResultCache::GetStats() const {
+    lock_guard guard(mutex_);
+    ResultCacheStats stats = stats_;
+    stats.capacity = capacity_.load(memory_order_relaxed);
+    stats.size = entries_.size();
+    return stats;
+}
+
+void ResultCache::SwitchGeneration(uint64_t generation) {
+    if (generation == generation_) {
+        return;
+    }
+    generation_ = generation;
+    if (!entries_.empty()) {
+        ++stats_.invalidations;
+        entries_.clear();
+        index_.clear();
+    }
+}
+
+void ResultCache::EvictExcess() {
+    while (entries_.size() > capacity_.load(memory_order_relaxed)) {
+        index_.erase(entries_.back().first);
+        entries_.pop_back();
+        ++stats_.evictions;
+    }
+}
@@ -0,0 +1,71 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <list>
+#include <mutex>
+#include <optional>
+#include <unordered_map>
+#include <vector>
+
+#include "document.h"
+#include "term_dictionary.h"
+
+// нормализованный запрос: отсортированные id плюс- и минус-слов без повторов, статус и окно выдачи
+struct ResultCacheKey {
+    std::vector<TermId> plus_terms;
+    std::vector<TermId> minus_terms;
+    DocumentStatus status = DocumentStatus::ACTUAL;
+    size_t offset = 0;
+    size_t count = 0;
+};
+
+bool operator==(const ResultCacheKey& lhs, const ResultCacheKey& rhs);
+
+struct ResultCacheKeyHasher {
+    size_t operator()(const ResultCacheKey& key) const;
+};
+
+struct ResultCacheStats {
+    size_t capacity = 0;
+    size_t size = 0;
+    uint64_t hits = 0;
+    uint64_t misses = 0;
+    uint64_t evictions = 0;
+    // сколько раз кэш сбрасывался из-за изменения индекса
+    uint64_t invalidations = 0;
+};
+
+// Потокобезопасный LRU-кэш выдачи не больше чем на capacity запросов; при capacity == 0 выключен.
+// Записи относятся к поколению индекса: обращение с другим поколением очищает кэш.
+// Копия кэша сохраняет только ёмкость
+class ResultCache {
+public:
+    explicit ResultCache(size_t capacity = 0);
+    ResultCache(const ResultCache& other);
+    ResultCache& operator=(const ResultCache& other);
+
+    // без блокировки: выключенный кэш не должен замедлять запросы
+    bool IsEnabled() const;
+    void SetCapacity(size_t capacity);
+
+    std::optional<std::vector<Document>> Find(const ResultCacheKey& key, uint64_t generation);
+    void Insert(ResultCacheKey key, uint64_t generation, std::vector<Document> documents);
+
+    ResultCacheStats GetStats() const;
+
+private:
+    using Entry = std::pair<ResultCacheKey, std::vector<Document>>;
+
+    mutable std::mutex mutex_;
+    // меняется под mutex_, а читается в IsEnabled и без него
+    std::atomic<size_t> capacity_;
+    uint64_t generation_ = 0;
+    // в начале списка — недавно использованные записи
+    std::list<Entry> entries_;
+    std::unordered_map<ResultCacheKey, std::list<Entry>::iterator, ResultCacheKeyHasher> index_;
+    ResultCacheStats stats_;
+
+    void SwitchGeneration(uint64_t generation);
+    void EvictExcess();
+};
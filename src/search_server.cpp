@@ -1,7 +1,10 @@
 #include <algorithm>
+#include <array>
 #include <cmath>
+#include <cstddef>
 #include <execution>
 
+#include "index_file.h"
 #include "search_server.h"
 #include "string_processing.h"
 #include "log_duration.h"
@@ -9,7 +12,7 @@
 using namespace std;
 
 SearchServer::SearchServer(const string_view stop_words_text)
-    : SearchServer(SplitIntoWords(stop_words_text)) {
+    : SearchServer(SplitIntoWordsView(stop_words_text)) {
 }
 
 SearchServer::SearchServer(const std::string& stop_words_text) 
@@ -19,20 +22,44 @@ SearchServer::SearchServer(const std::string& stop_words_text)
 
 
 void SearchServer::AddDocument(int document_id, const string_view document, DocumentStatus status, const vector<int>& ratings) {
-    if ((document_id < 0) || (documents_.count(document_id) > 0)) {
+    if ((document_id < 0) || documents_.Contains(document_id)) {
         throw invalid_argument("Invalid document_id"s);
     }
-    const auto words = SplitIntoWordsNoStop(document);
+    // временные массивы документа лежат в буфере на стеке, из кучи берётся только прямой индекс
+    array<byte, DOCUMENT_SCRATCH_SIZE> scratch_buffer;
+    pmr::monotonic_buffer_resource scratch(scratch_buffer.data(), scratch_buffer.size());
+    pmr::vector<string_view> words(&scratch);
+    SplitIntoWordsNoStop(document, words);
 
-    documents_.emplace(document_id, DocumentData{ComputeAverageRating(ratings), status, {}});
+    pmr::vector<TermId> term_ids(&scratch);
+    term_ids.reserve(words.size());
+    for (const string_view word : words) {
+        term_ids.push_back(terms_.Intern(word));
+    }
+    sort(term_ids.begin(), term_ids.end());
 
+    pmr::vector<pair<TermId, double>> term_freqs(&scratch);
     const double inv_word_count = 1.0 / words.size();
-    for (const string& word : words) {
-        const auto [it, _] = words_.insert(move(word));
-        word_to_document_freqs_[*it][document_id] += inv_word_count;
-        documents_[document_id].word_freqs[*it] += inv_word_count;
+    for (const TermId term_id : term_ids) {
+        if (term_freqs.empty() || term_freqs.back().first != term_id) {
+            term_freqs.push_back({term_id, 0.0});
+        }
+        term_freqs.back().second += inv_word_count;
+    }
+
+    const DocumentSlot slot = StoreDocument(document_id, status, ComputeAverageRating(ratings), {term_freqs.begin(), term_freqs.end()});
+    for (const auto& [term_id, term_freq] : document_data_[slot].term_freqs) {
+        postings_[term_id].Add(slot, term_freq, status);
     }
-    document_ids_.insert(document_id);
+    ++generation_;
+}
+
+void SearchServer::AddDocuments(const vector<DocumentToAdd>& documents) {
+    AddDocuments(execution::seq, documents);
+}
+
+vector<Document> SearchServer::FindTopDocuments(const string_view raw_query, DocumentStatus status, ResultWindow window) const {
+    return FindTopDocuments(execution::seq, raw_query, status, window);
 }
 
 vector<Document> SearchServer::FindTopDocuments(const string_view raw_query, DocumentStatus status) const {
@@ -44,50 +71,112 @@ vector<Document> SearchServer::FindTopDocuments(const string_view raw_query) con
 }
 
 int SearchServer::GetDocumentCount() const {
-    return documents_.size();
+    return documents_.Size();
+}
+
+void SearchServer::SetResultCacheCapacity(size_t capacity) {
+    result_cache_.SetCapacity(capacity);
+}
+
+ResultCacheStats SearchServer::GetResultCacheStats() const {
+    return result_cache_.GetStats();
 }
 
 tuple<vector<string_view>, DocumentStatus> SearchServer::MatchDocument(const string_view raw_query, int document_id) const {
     return MatchDocument(execution::seq, raw_query, document_id);
 }
 
-std::set<int>::iterator SearchServer::begin() const {
-    return document_ids_.begin();
+MatchedDocuments SearchServer::MatchDocuments(const string_view raw_query, const vector<int>& document_ids) const {
+    return MatchDocuments(execution::seq, raw_query, document_ids);
+}
+
+MatchedDocuments SearchServer::MatchDocuments(const string_view raw_query) const {
+    return MatchDocuments(execution::seq, raw_query);
 }
 
-std::set<int>::iterator SearchServer::end() const {
-    return document_ids_.end();
+DocumentStore::IdIterator SearchServer::begin() const {
+    return documents_.begin();
+}
+
+DocumentStore::IdIterator SearchServer::end() const {
+    return documents_.end();
 }
 
 const map<string_view, double>& SearchServer::GetWordFrequencies(int document_id) const {
-    if (documents_.count(document_id)) {
-        return documents_.at(document_id).word_freqs;
+    if (documents_.Contains(document_id)) {
+        const DocumentSlot slot = documents_.GetSlot(document_id);
+        lock_guard guard(word_freqs_cache_.mutex);
+        auto [it, inserted] = word_freqs_cache_.word_freqs.try_emplace(slot);
+        if (inserted) {
+            for (const auto& [term_id, term_freq] : document_data_[slot].term_freqs) {
+                it->second.emplace(terms_.GetWord(term_id), term_freq);
+            }
+        }
+        return it->second;
     }
     static map<string_view, double> dummy;
     return dummy;
 }
 
-bool SearchServer::IsStopWord(const string& word) const {
+const vector<pair<TermId, double>>& SearchServer::GetTermFrequencies(int document_id) const {
+    if (documents_.Contains(document_id)) {
+        return document_data_[documents_.GetSlot(document_id)].term_freqs;
+    }
+    static const vector<pair<TermId, double>> dummy;
+    return dummy;
+}
+
+bool SearchServer::IsStopWord(const string_view word) const {
     return stop_words_.count(word) > 0;
 }
 
-bool SearchServer::IsValidWord(const string& word) {
+bool SearchServer::IsValidWord(const string_view word) {
     return none_of(word.begin(), word.end(), [](char c) {
         return c >= '\0' && c < ' ';
     });
 }
 
-vector<string> SearchServer::SplitIntoWordsNoStop(const string_view text) const {
-    vector<string> words;
-    for (const string& word : SplitIntoWords(text)) {
-        if (!IsValidWord(word)) {
-            throw invalid_argument("Word "s + word + " is invalid"s);
+void SearchServer::SplitIntoWordsNoStop(const string_view text, pmr::vector<string_view>& words) const {
+    ScanWords(text, [this, &words](const string_view word, bool is_valid) {
+        if (!is_valid) {
+            throw invalid_argument("Word "s + string(word) + " is invalid"s);
         }
         if (!IsStopWord(word)) {
-            words.push_back(move(word));
+            words.push_back(word);
         }
+    });
+}
+
+vector<pair<string_view, double>> SearchServer::ComputeWordFreqs(const string_view text) const {
+    array<byte, DOCUMENT_SCRATCH_SIZE> scratch_buffer;
+    pmr::monotonic_buffer_resource scratch(scratch_buffer.data(), scratch_buffer.size());
+    pmr::vector<string_view> words(&scratch);
+    SplitIntoWordsNoStop(text, words);
+    sort(words.begin(), words.end());
+
+    vector<pair<string_view, double>> word_freqs;
+    const double inv_word_count = 1.0 / words.size();
+    for (const string_view word : words) {
+        if (word_freqs.empty() || word_freqs.back().first != word) {
+            word_freqs.push_back({word, 0.0});
+        }
+        word_freqs.back().second += inv_word_count;
+    }
+    return word_freqs;
+}
+
+DocumentSlot SearchServer::StoreDocument(int document_id, DocumentStatus status, int rating, vector<pair<TermId, double>> term_freqs) {
+    const DocumentSlot slot = documents_.Add(document_id, status, rating);
+    if (document_data_.size() < documents_.SlotCount()) {
+        document_data_.resize(documents_.SlotCount());
+    }
+    auto& document_data = document_data_[slot];
+
+    document_data.term_freqs = move(term_freqs);
+    if (postings_.size() < terms_.Size()) {
+        postings_.resize(terms_.Size());
     }
-    return words;
+    return slot;
 }
 
 int SearchServer::ComputeAverageRating(const vector<int>& ratings) {
@@ -101,42 +190,226 @@ int SearchServer::ComputeAverageRating(const vector<int>& ratings) {
     return rating_sum / static_cast<int>(ratings.size());
 }
 
-SearchServer::QueryWord SearchServer::ParseQueryWord(const string& text) const {
+SearchServer::QueryWord SearchServer::ParseQueryWord(const string_view text, bool is_valid) const {
     if (text.empty()) {
         throw invalid_argument("Query word is empty"s);
     }
-    string word = text;
+    string_view word = text;
     bool is_minus = false;
     if (word[0] == '-') {
         is_minus = true;
-        word = word.substr(1);
+        word.remove_prefix(1);
     }
-    if (word.empty() || word[0] == '-' || !IsValidWord(word)) {
-        throw invalid_argument("Query word "s + text + " is invalid");
+    if (word.empty() || word[0] == '-' || !is_valid) {
+        throw invalid_argument("Query word "s + string(text) + " is invalid");
     }
 
     return {word, is_minus, IsStopWord(word)};
 }
 
-SearchServer::Query SearchServer::ParseQuery(const string_view text) const {
-    Query result;
-    for (const string& word : SplitIntoWords(text)) {
-        const auto query_word = ParseQueryWord(word);
-        if (!query_word.is_stop) {
-            if (query_word.is_minus) {
-                result.minus_words.insert(query_word.data);
-            } else {
-                result.plus_words.insert(query_word.data);
+void SearchServer::ParseQuery(const string_view text, Query& query) const {
+    query.plus_terms.clear();
+    query.minus_terms.clear();
+    ScanWords(text, [this, &query](const string_view word, bool is_valid) {
+        const auto query_word = ParseQueryWord(word, is_valid);
+        if (query_word.is_stop) {
+            return;
+        }
+        // слова, которых нет в словаре, не встречаются ни в одном документе
+        const auto term_id = terms_.Find(query_word.data);
+        if (!term_id) {
+            return;
+        }
+        if (query_word.is_minus) {
+            query.minus_terms.push_back(*term_id);
+        } else {
+            query.plus_terms.push_back(*term_id);
+        }
+    });
+    for (auto* term_ids : {&query.plus_terms, &query.minus_terms}) {
+        sort(term_ids->begin(), term_ids->end());
+        term_ids->erase(unique(term_ids->begin(), term_ids->end()), term_ids->end());
+    }
+}
+
+vector<SearchServer::PostingRange> SearchServer::SplitPostings(const vector<TermId>& term_ids, StatusMask statuses) const {
+    vector<PostingRange> result;
+    for (const TermId term_id : term_ids) {
+        const PostingList& postings = postings_[term_id];
+        if (postings.Empty()) {
+            continue;
+        }
+        const double inverse_document_freq = postings.GetInverseDocumentFreq(documents_.Size());
+        for (size_t status_index = 0; status_index < DOCUMENT_STATUS_COUNT; ++status_index) {
+            if (!statuses.test(status_index)) {
+                continue;
+            }
+            const auto status = static_cast<DocumentStatus>(status_index);
+            const size_t last = postings.Slots(status).size();
+            for (size_t first = 0; first < last; first += POSTING_RANGE_SIZE) {
+                result.push_back({&postings, status, first, min(last, first + POSTING_RANGE_SIZE), inverse_document_freq});
             }
         }
     }
     return result;
 }
 
-double SearchServer::ComputeWordInverseDocumentFreq(const string_view word) const {
-    return log(GetDocumentCount() * 1.0 / word_to_document_freqs_.at(word).size());
+const SlotBitmap* SearchServer::MarkExcludedSlots(const Query& query, SlotBitmap& bitmap) const {
+    if (query.minus_terms.empty()) {
+        return nullptr;
+    }
+    bitmap.Reset(documents_.SlotCount());
+    for (const TermId term_id : query.minus_terms) {
+        const PostingList& postings = postings_[term_id];
+        for (size_t status_index = 0; status_index < DOCUMENT_STATUS_COUNT; ++status_index) {
+            const auto status = static_cast<DocumentStatus>(status_index);
+            const auto& slots = postings.Slots(status);
+            const auto& term_freqs = postings.TermFreqs(status);
+            for (size_t i = 0; i < slots.size(); ++i) {
+                if (!PostingList::IsRemoved(term_freqs[i])) {
+                    bitmap.Set(slots[i]);
+                }
+            }
+        }
+    }
+    return &bitmap;
+}
+
+vector<Document> SearchServer::BuildMatchedDocuments(const map<DocumentSlot, double>& document_to_relevance) const {
+    vector<Document> matched_documents;
+    matched_documents.reserve(document_to_relevance.size());
+    for (const auto [slot, relevance] : document_to_relevance) {
+        matched_documents.push_back({documents_.GetId(slot), relevance, documents_.GetRating(slot)});
+    }
+    return matched_documents;
+}
+
+
+namespace {
+
+// пишет values[i] для вхождений, не отмеченных удалёнными, отрезками между удалёнными
+template <typename T>
+void WriteLivePostings(IndexFileWriter& writer, const vector<T>& values, const vector<double>& term_freqs) {
+    size_t first = 0;
+    for (size_t i = 0; i <= values.size(); ++i) {
+        if (i == values.size() || PostingList::IsRemoved(term_freqs[i])) {
+            writer.WriteElements(values.data() + first, i - first);
+            first = i + 1;
+        }
+    }
 }
 
+}  // namespace
+
+void SearchServer::SaveIndex(const string& path) const {
+    IndexFileWriter writer(path);
+    writer.WriteStrings(vector<string_view>(stop_words_.begin(), stop_words_.end()));
+
+    vector<string_view> words;
+    words.reserve(terms_.Size());
+    for (TermId term_id = 0; term_id < terms_.Size(); ++term_id) {
+        words.push_back(terms_.GetWord(term_id));
+    }
+    writer.WriteStrings(words);
+
+    vector<uint64_t> posting_offsets = {0};
+    posting_offsets.reserve(postings_.size() + 1);
+    for (const PostingList& postings : postings_) {
+        posting_offsets.push_back(posting_offsets.back() + postings.Size());
+    }
+    writer.WriteArray(posting_offsets);
+    // вхождения пишутся по статусам
+    writer.BeginArray<DocumentSlot>(posting_offsets.back());
+    for (const PostingList& postings : postings_) {
+        for (size_t status_index = 0; status_index < DOCUMENT_STATUS_COUNT; ++status_index) {
+            const auto status = static_cast<DocumentStatus>(status_index);
+            WriteLivePostings(writer, postings.Slots(status), postings.TermFreqs(status));
+        }
+    }
+    writer.EndArray();
+    writer.BeginArray<double>(posting_offsets.back());
+    for (const PostingList& postings : postings_) {
+        for (size_t status_index = 0; status_index < DOCUMENT_STATUS_COUNT; ++status_index) {
+            const auto& term_freqs = postings.TermFreqs(static_cast<DocumentStatus>(status_index));
+            WriteLivePostings(writer, term_freqs, term_freqs);
+        }
+    }
+    writer.EndArray();
+
+    writer.WriteArray(documents_.Ids());
+    writer.WriteArray(documents_.Statuses());
+    writer.WriteArray(documents_.Ratings());
+    writer.Finish();
+}
+
+SearchServer SearchServer::LoadIndex(const string& path) {
+    IndexFileReader reader(path);
+    SearchServer search_server(reader.ReadStrings());
+
+    const auto words = reader.ReadStrings();
+    for (const string_view word : words) {
+        search_server.terms_.Intern(word);
+    }
+    const auto posting_offsets = reader.ReadArray<uint64_t>();
+    const auto slots = reader.ReadArray<DocumentSlot>();
+    const auto term_freqs = reader.ReadArray<double>();
+    const auto ids = reader.ReadArray<int>();
+    const auto statuses = reader.ReadArray<DocumentStatus>();
+    const auto ratings = reader.ReadArray<int>();
+
+    const bool is_consistent = search_server.terms_.Size() == words.size()
+        && posting_offsets.size == words.size() + 1 && posting_offsets[0] == 0
+        && is_sorted(posting_offsets.begin(), posting_offsets.end())
+        && posting_offsets[words.size()] == slots.size && slots.size == term_freqs.size
+        && statuses.size == ids.size && ratings.size == ids.size
+        && all_of(slots.begin(), slots.end(), [&ids](DocumentSlot slot) { return slot < ids.size && ids[slot] >= 0; })
+        // нулевая частота означает удалённое вхождение (PostingList::REMOVED_TERM_FREQ), такие в файл не пишутся
+        && all_of(term_freqs.begin(), term_freqs.end(), [](double term_freq) { return isfinite(term_freq) && term_freq > 0.0; })
+        && all_of(statuses.begin(), statuses.end(), [](DocumentStatus status) {
+            return status >= DocumentStatus::ACTUAL && status <= DocumentStatus::REMOVED;
+        });
+    if (!is_consistent) {
+        throw runtime_error("Index file is corrupted"s);
+    }
+
+    try {
+        search_server.documents_ = DocumentStore(vector(ids.begin(), ids.end()), vector(statuses.begin(), statuses.end()), vector(ratings.begin(), ratings.end()));
+    } catch (const invalid_argument&) {
+        throw runtime_error("Index file is corrupted"s);
+    }
+    auto& document_data = search_server.document_data_;
+    document_data.resize(ids.size);
+    vector<size_t> document_term_counts(ids.size, 0);
+    for (const DocumentSlot slot : slots) {
+        ++document_term_counts[slot];
+    }
+    for (DocumentSlot slot = 0; slot < ids.size; ++slot) {
+        document_data[slot].term_freqs.reserve(document_term_counts[slot]);
+    }
+
+    search_server.postings_.reserve(words.size());
+    for (TermId term_id = 0; term_id < words.size(); ++term_id) {
+        const size_t first = posting_offsets[term_id];
+        const size_t last = posting_offsets[term_id + 1];
+        // внутри части одного статуса слоты идут строго по возрастанию, иначе документ попал в список дважды
+        array<int64_t, DOCUMENT_STATUS_COUNT> last_slots;
+        last_slots.fill(-1);
+        for (size_t i = first; i < last; ++i) {
+            int64_t& last_slot = last_slots[static_cast<size_t>(statuses[slots[i]])];
+            if (slots[i] <= last_slot) {
+                throw runtime_error("Index file is corrupted"s);
+            }
+            last_slot = slots[i];
+        }
+        search_server.postings_.emplace_back(vector(slots.data + first, slots.data + last), vector(term_freqs.data + first, term_freqs.data + last),
+                                             search_server.documents_.Statuses());
+        // прямой индекс восстанавливается из списков вхождений, слова идут по возрастанию id
+        for (size_t i = first; i < last; ++i) {
+            document_data[slots[i]].term_freqs.push_back({term_id, term_freqs[i]});
+        }
+    }
+    return search_server;
+}
 
 void PrintMatchDocumentResult(int document_id, const vector<string_view>& words, DocumentStatus status) {
     cout << "{ "s
@@ -174,9 +447,10 @@ void MatchDocuments(const SearchServer& search_server, const string& query) {
     LOG_DURATION_STREAM("Operation time"s, cout);
     try {
         cout << "Матчинг документов по запросу: "s << query << endl;
-        for (const int document_id : search_server) {
-            const auto [words, status] = search_server.MatchDocument(query, document_id);
-            PrintMatchDocumentResult(document_id, words, status);
+        const MatchedDocuments matched = search_server.MatchDocuments(query);
+        for (size_t i = 0; i < matched.document_ids.size(); ++i) {
+            const vector<string_view> words(matched.words.begin() + matched.offsets[i], matched.words.begin() + matched.offsets[i + 1]);
+            PrintMatchDocumentResult(matched.document_ids[i], words, matched.statuses[i]);
         }
     } catch (const invalid_argument& e) {
         cout << "Ошибка матчинга документов на запрос "s << query << ": "s << e.what() << endl;
@@ -185,4 +459,17 @@ void MatchDocuments(const SearchServer& search_server, const string& query) {
 
 void SearchServer::RemoveDocument(int document_id) {
     RemoveDocument(std::execution::seq, document_id);
-}
\ No newline at end of file
+}
+
+void SearchServer::SetDocumentStatus(int document_id, DocumentStatus status) {
+    const DocumentSlot slot = documents_.GetSlot(document_id);
+    const DocumentStatus old_status = documents_.GetStatus(slot);
+    if (old_status == status) {
+        return;
+    }
+    for (const auto& [term_id, _] : document_data_[slot].term_freqs) {
+        postings_[term_id].ChangeStatus(slot, old_status, status);
+    }
+    documents_.SetStatus(slot, status);
+    ++generation_;
+}
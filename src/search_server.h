@@ -6,18 +6,58 @@
 #include <set>
 #include <unordered_set>
 #include <tuple>
+#include <bitset>
 #include <map>
+#include <limits>
 #include <unordered_map>
 #include <stdexcept>
 #include <algorithm>
 #include <execution>
+#include <exception>
+#include <mutex>
+#include <numeric>
+#include <memory_resource>
 
 #include "document.h"
 #include "string_processing.h"
 #include "log_duration.h"
 #include "concurrent_map.h"
+#include "document_store.h"
+#include "posting_list.h"
+#include "result_cache.h"
+#include "slot_bitmap.h"
+#include "term_dictionary.h"
+#include "top_documents.h"
+
+const size_t RELEVANCE_BUCKET_COUNT = 101;
+const size_t POSTING_RANGE_SIZE = 2048;
+// буфер на стеке для временных массивов разбора документа; хватает на документы в пару сотен слов, длинным добавляется память из кучи
+const size_t DOCUMENT_SCRATCH_SIZE = 8 * 1024;
+// сколько документов пакетного матчинга обрабатывает один поток
+const size_t MATCH_CHUNK_SIZE = 1024;
+
+// какую часть выдачи вернуть: count документов, начиная с позиции offset
+struct ResultWindow {
+    size_t offset = 0;
+    size_t count = MAX_RESULT_DOCUMENT_COUNT;
+};
+
+// Результат SearchServer::MatchDocuments: у документа document_ids[i] статус statuses[i],
+// а найденные в нём слова запроса лежат в words[offsets[i], offsets[i + 1]) — так же, как их вернул бы MatchDocument
+struct MatchedDocuments {
+    std::vector<int> document_ids;
+    std::vector<DocumentStatus> statuses;
+    std::vector<std::string_view> words;
+    std::vector<size_t> offsets;
+};
 
-const int MAX_RESULT_DOCUMENT_COUNT = 5;
+// документ для пакетного добавления через SearchServer::AddDocuments
+struct DocumentToAdd {
+    int id = 0;
+    std::string_view text;
+    DocumentStatus status = DocumentStatus::ACTUAL;
+    std::vector<int> ratings;
+};
 
 class SearchServer {
 public:
@@ -28,25 +68,34 @@ public:
 
     void AddDocument(int document_id, const std::string_view document, DocumentStatus status, const std::vector<int>& ratings);
 
-    template <typename ExecutionPolicy, typename DocumentPredicate>
-    std::vector<Document> FindTopDocuments(ExecutionPolicy&& policy, const std::string_view raw_query, DocumentPredicate document_predicate) const {
-        const auto query = ParseQuery(raw_query);
-
-        auto matched_documents = FindAllDocuments(policy, query, document_predicate);
+    // Добавляет пакет документов: тексты разбираются параллельно, затем индекс пополняется за один шаг.
+    // Ошибки те же, что у AddDocument, для первого в пакете некорректного документа, но при ошибке не добавляется ни один документ
+    template <typename ExecutionPolicy>
+    void AddDocuments(ExecutionPolicy&& policy, const std::vector<DocumentToAdd>& documents);
+    void AddDocuments(const std::vector<DocumentToAdd>& documents);
 
-        std::sort(policy, matched_documents.begin(), matched_documents.end(), [](const Document& lhs, const Document& rhs) {
-            if (std::abs(lhs.relevance - rhs.relevance) < 1e-6) {
-                return lhs.rating > rhs.rating;
-            } else {
-                return lhs.relevance > rhs.relevance;
+    // выдача по произвольному предикату не кэшируется: предикат нельзя сравнить с ранее переданными
+    template <typename ExecutionPolicy, typename DocumentPredicate>
+    std::vector<Document> FindTopDocuments(ExecutionPolicy&& policy, const std::string_view raw_query, DocumentPredicate document_predicate, ResultWindow window) const {
+        PROFILE_SCOPE("FindTopDocuments");
+        // при последовательном поиске разбор запроса переиспользует буферы потока и в обычном случае не выделяет память
+        return WithScratch<Query, ExecutionPolicy>([&](Query& query) {
+            {
+                PROFILE_SCOPE("parse");
+                ParseQuery(raw_query, query);
             }
+            return FindTopDocuments(policy, query, StatusMask().set(), document_predicate, window);
         });
+    }
 
-        if (matched_documents.size() > MAX_RESULT_DOCUMENT_COUNT) {
-            matched_documents.resize(MAX_RESULT_DOCUMENT_COUNT);
-        }
+    template <typename ExecutionPolicy, typename DocumentPredicate>
+    std::vector<Document> FindTopDocuments(ExecutionPolicy&& policy, const std::string_view raw_query, DocumentPredicate document_predicate) const {
+        return FindTopDocuments(policy, raw_query, document_predicate, ResultWindow{});
+    }
 
-        return matched_documents;
+    template <typename DocumentPredicate>
+    std::vector<Document> FindTopDocuments(const std::string_view raw_query, DocumentPredicate document_predicate, ResultWindow window) const {
+        return FindTopDocuments(std::execution::seq, raw_query, document_predicate, window);
     }
 
     template <typename DocumentPredicate>
@@ -54,102 +103,429 @@ public:
         return FindTopDocuments(std::execution::seq, raw_query, document_predicate);
     }
 
+    // Разобранный запрос: слова, которые есть в словаре, в виде отсортированных id без повторов.
+    // Выдача по нему совпадает с выдачей по тексту запроса, пока в словарь не добавлены новые слова
+    struct Query {
+        std::vector<TermId> plus_terms;
+        std::vector<TermId> minus_terms;
+    };
+
+    // бросает std::invalid_argument для некорректного запроса
+    void ParseQuery(const std::string_view text, Query& query) const;
+
+    // при включённом кэше выдачи (SetResultCacheCapacity) повторный запрос с тем же набором слов,
+    // статусом и окном берётся из кэша, пока индекс не изменится
+    template <typename ExecutionPolicy>
+    std::vector<Document> FindTopDocuments(ExecutionPolicy&& policy, const std::string_view raw_query, DocumentStatus status, ResultWindow window) const;
+    // то же для запроса, разобранного заранее
+    template <typename ExecutionPolicy>
+    std::vector<Document> FindTopDocuments(ExecutionPolicy&& policy, const Query& query, DocumentStatus status, ResultWindow window) const;
+
     template <typename ExecutionPolicy> 
     std::vector<Document> FindTopDocuments(ExecutionPolicy&& policy, const std::string_view raw_query, DocumentStatus status) const {
-        return FindTopDocuments(policy, raw_query, [status](int document_id, DocumentStatus document_status, int rating) {
-            return document_status == status;
-        });
+        return FindTopDocuments(policy, raw_query, status, ResultWindow{});
     }
+
     template <typename ExecutionPolicy>
     std::vector<Document> FindTopDocuments(ExecutionPolicy&& policy, const std::string_view raw_query) const {
         return FindTopDocuments(policy, raw_query, DocumentStatus::ACTUAL);
     }
 
+    std::vector<Document> FindTopDocuments(const std::string_view raw_query, DocumentStatus status, ResultWindow window) const;
     std::vector<Document> FindTopDocuments(const std::string_view raw_query, DocumentStatus status) const;
     std::vector<Document> FindTopDocuments(const std::string_view raw_query) const;
 
     int GetDocumentCount() const;
 
+    // ёмкость кэша выдачи в запросах; 0 (по умолчанию) выключает кэш
+    void SetResultCacheCapacity(size_t capacity);
+    ResultCacheStats GetResultCacheStats() const;
+
     template <typename ExecutionPolicy>
     std::tuple<std::vector<std::string_view>, DocumentStatus> MatchDocument(ExecutionPolicy&& policy, const std::string_view raw_query, int document_id) const;
     std::tuple<std::vector<std::string_view>, DocumentStatus> MatchDocument(const std::string_view raw_query, int document_id) const;
 
-    std::set<int>::iterator begin() const;
-    std::set<int>::iterator end() const;
+    // Матчинг запроса с документами document_ids (без него — со всеми документами по возрастанию id).
+    // Запрос разбирается один раз, а список вхождений каждого слова обходится вместе с отсортированными слотами документов.
+    // Параллельная версия делит документы на части по MATCH_CHUNK_SIZE; для неизвестного id бросает std::out_of_range
+    template <typename ExecutionPolicy>
+    MatchedDocuments MatchDocuments(ExecutionPolicy&& policy, const std::string_view raw_query, const std::vector<int>& document_ids) const;
+    template <typename ExecutionPolicy>
+    MatchedDocuments MatchDocuments(ExecutionPolicy&& policy, const std::string_view raw_query) const;
+    MatchedDocuments MatchDocuments(const std::string_view raw_query, const std::vector<int>& document_ids) const;
+    MatchedDocuments MatchDocuments(const std::string_view raw_query) const;
+
+    DocumentStore::IdIterator begin() const;
+    DocumentStore::IdIterator end() const;
 
     const std::map<std::string_view, double>& GetWordFrequencies(int document_id) const;
+    // прямой индекс документа: id слов по возрастанию и их частоты; для неизвестного id — пустой
+    const std::vector<std::pair<TermId, double>>& GetTermFrequencies(int document_id) const;
     
     template <typename ExecutionPolicy>
     void RemoveDocument(ExecutionPolicy&& policy, int document_id);
     void RemoveDocument(int document_id);
+
+    // меняет статус документа, не разбирая его заново; для неизвестного id бросает std::out_of_range
+    void SetDocumentStatus(int document_id, DocumentStatus status);
+
+    // Сохраняет индекс в двоичный файл (см. index_file.h), чтобы при перезапуске не разбирать документы заново.
+    // SaveIndex подменяет файл целиком только после успешной записи, прежний индекс при сбое остаётся.
+    // LoadIndex отображает файл в память и копирует массивы целиком; при ошибке бросает std::runtime_error
+    void SaveIndex(const std::string& path) const;
+    static SearchServer LoadIndex(const std::string& path);
  
 private:
     struct DocumentData {
-        int rating;
-        DocumentStatus status;
-        std::map<std::string_view, double> word_freqs;
+        // прямой индекс: id слов документа по возрастанию и их частоты
+        std::vector<std::pair<TermId, double>> term_freqs;
     };
-    std::set<std::string> words_;
-    const std::set<std::string> stop_words_;
+
+    // Словари частот для GetWordFrequencies строятся по прямому индексу при первом запросе.
+    // Копия сервера начинает с пустого кэша
+    struct WordFreqsCache {
+        WordFreqsCache() = default;
+        WordFreqsCache(const WordFreqsCache&) {
+        }
+        WordFreqsCache& operator=(const WordFreqsCache&) {
+            return *this;
+        }
+
+        std::mutex mutex;
+        std::unordered_map<DocumentSlot, std::map<std::string_view, double>> word_freqs;
+    };
+    TermDictionary terms_;
+    const std::set<std::string, std::less<>> stop_words_;
     
-    std::map<std::string_view, std::map<int, double>> word_to_document_freqs_;
-    std::map<int, DocumentData> documents_;
-    std::set<int> document_ids_;
+    // списки вхождений, индекс в векторе — id слова в terms_
+    std::vector<PostingList> postings_;
+    DocumentStore documents_;
+    // индекс в векторе — слот документа в documents_
+    std::vector<DocumentData> document_data_;
+    mutable WordFreqsCache word_freqs_cache_;
+    // поколение индекса: меняется при каждом добавлении и удалении документов
+    uint64_t generation_ = 0;
+    mutable ResultCache result_cache_;
 
-    bool IsStopWord(const std::string& word) const;
+    bool IsStopWord(const std::string_view word) const;
 
-    static bool IsValidWord(const std::string& word);
+    static bool IsValidWord(const std::string_view word);
 
-    std::vector<std::string> SplitIntoWordsNoStop(const std::string_view text) const;
+    // добавляет в words слова text, кроме стоп-слов; для слова с управляющими символами бросает std::invalid_argument
+    void SplitIntoWordsNoStop(const std::string_view text, std::pmr::vector<std::string_view>& words) const;
 
     static int ComputeAverageRating(const std::vector<int>& ratings);
 
+    // частоты слов документа, отсортированные по слову
+    std::vector<std::pair<std::string_view, double>> ComputeWordFreqs(const std::string_view text) const;
+    // заводит слот и прямой индекс документа (term_freqs отсортированы по id слова), списки вхождений не меняет
+    DocumentSlot StoreDocument(int document_id, DocumentStatus status, int rating, std::vector<std::pair<TermId, double>> term_freqs);
+
     struct QueryWord {
-        std::string data;
+        std::string_view data;
         bool is_minus;
         bool is_stop;
     };
 
-    QueryWord ParseQueryWord(const std::string& text) const;
+    // is_valid — результат проверки слова на управляющие символы, сделанной при разбиении текста
+    QueryWord ParseQueryWord(const std::string_view text, bool is_valid) const;
 
-    struct Query {
-        std::set<std::string> plus_words;
-        std::set<std::string> minus_words;
+    template <typename ExecutionPolicy>
+    std::tuple<std::vector<std::string_view>, DocumentStatus> MatchDocument(ExecutionPolicy&& policy, const Query& query, int document_id) const;
+    template <typename ExecutionPolicy>
+    MatchedDocuments MatchDocuments(ExecutionPolicy&& policy, const Query& query, const std::vector<int>& document_ids) const;
+
+    // часть вхождений одного слова и одного статуса, обрабатываемая одним потоком
+    struct PostingRange {
+        const PostingList* postings;
+        DocumentStatus status;
+        size_t first;
+        size_t last;
+        double inverse_document_freq;
     };
 
-    Query ParseQuery(const std::string_view text) const;
-    double ComputeWordInverseDocumentFreq(const std::string_view word) const;
-    
+    // статусы документов, вхождения которых обходит поиск; бит с номером static_cast<size_t>(status)
+    using StatusMask = std::bitset<DOCUMENT_STATUS_COUNT>;
+
+    template <typename ExecutionPolicy>
+    static constexpr bool IS_SEQUENCED = std::is_same_v<std::decay_t<ExecutionPolicy>, std::execution::sequenced_policy>;
+
+    // Вызывает function(буфер типа T) и возвращает её результат. При последовательном выполнении буфер — переменная потока,
+    // переиспользуемая между вызовами. Параллельный алгоритм, дожидаясь своих задач, может выполнить в том же потоке
+    // задачу другого запроса, которая затёрла бы такой буфер, поэтому параллельный вызов получает свой буфер
+    template <typename T, typename ExecutionPolicy, typename Function>
+    static decltype(auto) WithScratch(Function function) {
+        if constexpr (IS_SEQUENCED<ExecutionPolicy>) {
+            thread_local T scratch;
+            return function(scratch);
+        } else {
+            T scratch;
+            return function(scratch);
+        }
+    }
+
+    // Последовательный поиск идёт документ за документом с отсечением (MaxScore), параллельный — полным перебором.
+    // Обходятся только части списков вхождений со статусами из statuses, документы из них проверяются предикатом.
+    // Документы с минус-словами отмечаются в битовой карте заранее, и релевантность для них не считается
     template <typename ExecutionPolicy, typename DocumentPredicate>
-    std::vector<Document> FindAllDocuments(ExecutionPolicy&& policy, const SearchServer::Query& query, DocumentPredicate document_predicate) const {
-        std::map<int, double> document_to_relevance;
-        for (const std::string& word : query.plus_words) {
-            if (word_to_document_freqs_.count(word) == 0) {
+    std::vector<Document> FindTopDocuments(ExecutionPolicy&& policy, const Query& query, StatusMask statuses, DocumentPredicate document_predicate, ResultWindow window) const {
+        return WithScratch<SlotBitmap, ExecutionPolicy>([&](SlotBitmap& bitmap) {
+            const SlotBitmap* excluded_slots;
+            {
+                PROFILE_SCOPE("filter");
+                excluded_slots = MarkExcludedSlots(query, bitmap);
+            }
+
+            if constexpr (IS_SEQUENCED<ExecutionPolicy>) {
+                return FindTopDocumentsPruned(query, statuses, excluded_slots, document_predicate, window);
+            } else {
+                auto matched_documents = FindAllDocuments(policy, query, statuses, excluded_slots, document_predicate);
+
+                PROFILE_SCOPE("topk");
+                return SelectTopDocuments(policy, std::move(matched_documents), window.offset, window.count);
+            }
+        });
+    }
+
+    // Обходит списки вхождений плюс-слов одновременно, по возрастанию слота. Курсоры (часть списка одного статуса)
+    // упорядочены по верхней оценке вклада (наибольшая частота * IDF); когда top-K заполнен, курсоры с суммарной оценкой
+    // ниже порога входа становятся неосновными: документы, которые есть только в них, не рассматриваются, а в остальных
+    // они проверяются поиском, пока оценка документа не опустится ниже порога. Порог берётся с запасом RELEVANCE_EPSILON,
+    // а релевантность складывается в порядке id слов, как при полном переборе, поэтому выдача с ним совпадает
+    template <typename DocumentPredicate>
+    std::vector<Document> FindTopDocumentsPruned(const Query& query, StatusMask statuses, const SlotBitmap* excluded_slots, DocumentPredicate& document_predicate, ResultWindow window) const {
+        if (window.offset >= documents_.Size() || window.count == 0) {
+            return {};
+        }
+        TopDocumentsCollector collector(window.offset + std::min(window.count, documents_.Size() - window.offset));
+        {
+            PROFILE_SCOPE("postings");
+            CollectTopDocumentsPruned(query, statuses, excluded_slots, document_predicate, collector);
+        }
+
+        PROFILE_SCOPE("topk");
+        auto top = collector.ExtractSorted();
+        top.erase(top.begin(), top.begin() + std::min(window.offset, top.size()));
+        top.resize(std::min(top.size(), window.count));
+        return top;
+    }
+
+    // обход списков вхождений для FindTopDocumentsPruned вместе с проверкой фильтров и отбором в collector
+    template <typename DocumentPredicate>
+    void CollectTopDocumentsPruned(const Query& query, StatusMask statuses, const SlotBitmap* excluded_slots, DocumentPredicate& document_predicate, TopDocumentsCollector& collector) const {
+        struct TermCursor {
+            const DocumentSlot* slots;
+            const double* term_freqs;
+            // номер слова в запросе
+            size_t term_index;
+            double inverse_document_freq;
+            double max_score;
+            size_t position;
+            size_t end;
+        };
+        // буферы потока переиспользуются между запросами, чтобы поиск не выделял память
+        struct Scratch {
+            std::vector<TermCursor> cursors;
+            std::vector<size_t> order;
+            std::vector<double> bound_prefix;
+            std::vector<double> contributions;
+            std::vector<char> has_term;
+        };
+        thread_local Scratch scratch;
+        // курсор всегда стоит на живом вхождении или в конце
+        const auto skip_removed = [](TermCursor& cursor) {
+            while (cursor.position < cursor.end && PostingList::IsRemoved(cursor.term_freqs[cursor.position])) {
+                ++cursor.position;
+            }
+        };
+
+        // слова запроса по возрастанию id, у каждого по курсору на статус
+        auto& cursors = scratch.cursors;
+        cursors.clear();
+        size_t term_count = 0;
+        for (const TermId term_id : query.plus_terms) {
+            const PostingList& postings = postings_[term_id];
+            if (postings.Empty()) {
                 continue;
             }
-            const double inverse_document_freq = ComputeWordInverseDocumentFreq(word);
-            for (const auto [document_id, term_freq] : word_to_document_freqs_.at(word)) {
-                const auto& document_data = documents_.at(document_id);
-                if (document_predicate(document_id, document_data.status, document_data.rating)) {
-                    document_to_relevance[document_id] += term_freq * inverse_document_freq;
+            const double inverse_document_freq = postings.GetInverseDocumentFreq(documents_.Size());
+            for (size_t status_index = 0; status_index < DOCUMENT_STATUS_COUNT; ++status_index) {
+                const auto status = static_cast<DocumentStatus>(status_index);
+                if (statuses.test(status_index) && !postings.Slots(status).empty()) {
+                    TermCursor cursor{postings.Slots(status).data(), postings.TermFreqs(status).data(), term_count, inverse_document_freq,
+                                      postings.MaxTermFreq(status) * inverse_document_freq, 0, postings.Slots(status).size()};
+                    skip_removed(cursor);
+                    cursors.push_back(cursor);
                 }
             }
+            ++term_count;
+        }
+
+        // номера курсоров по возрастанию оценки и суммы оценок первых i из них
+        auto& order = scratch.order;
+        order.resize(cursors.size());
+        std::iota(order.begin(), order.end(), 0);
+        std::sort(order.begin(), order.end(), [&cursors](size_t lhs, size_t rhs) {
+            return cursors[lhs].max_score < cursors[rhs].max_score;
+        });
+        auto& bound_prefix = scratch.bound_prefix;
+        bound_prefix.assign(cursors.size() + 1, 0.0);
+        for (size_t i = 0; i < order.size(); ++i) {
+            bound_prefix[i + 1] = bound_prefix[i] + cursors[order[i]].max_score;
         }
 
-        for (const std::string& word : query.minus_words) {
-            if (word_to_document_freqs_.count(word) == 0) {
+        // документ есть не больше чем в одной части списка слова, поэтому вклад слова задаёт один курсор
+        auto& contributions = scratch.contributions;
+        contributions.resize(term_count);
+        auto& has_term = scratch.has_term;
+        has_term.resize(term_count);
+        double threshold = -std::numeric_limits<double>::infinity();
+        // order[0, essential_begin) — неосновные курсоры
+        size_t essential_begin = 0;
+
+        while (true) {
+            DocumentSlot slot = std::numeric_limits<DocumentSlot>::max();
+            for (size_t k = essential_begin; k < order.size(); ++k) {
+                const TermCursor& cursor = cursors[order[k]];
+                if (cursor.position < cursor.end) {
+                    slot = std::min(slot, cursor.slots[cursor.position]);
+                }
+            }
+            if (slot == std::numeric_limits<DocumentSlot>::max()) {
+                break;
+            }
+
+            // фильтры проверяются до подсчёта вклада слов, у отброшенного документа только сдвигаются курсоры
+            const bool is_excluded = IsExcluded(excluded_slots, slot) || !MatchesPredicate(slot, document_predicate);
+            std::fill(has_term.begin(), has_term.end(), 0);
+            double score_bound = bound_prefix[essential_begin];
+            for (size_t k = essential_begin; k < order.size(); ++k) {
+                TermCursor& cursor = cursors[order[k]];
+                if (cursor.position < cursor.end && cursor.slots[cursor.position] == slot) {
+                    if (!is_excluded) {
+                        contributions[cursor.term_index] = cursor.term_freqs[cursor.position] * cursor.inverse_document_freq;
+                        has_term[cursor.term_index] = 1;
+                        score_bound += contributions[cursor.term_index];
+                    }
+                    ++cursor.position;
+                    skip_removed(cursor);
+                }
+            }
+            if (is_excluded || score_bound < threshold) {
                 continue;
             }
-            for (const auto [document_id, _] : word_to_document_freqs_.at(word)) {
-                document_to_relevance.erase(document_id);
+
+            for (size_t k = essential_begin; k-- > 0 && score_bound >= threshold;) {
+                TermCursor& cursor = cursors[order[k]];
+                cursor.position = std::lower_bound(cursor.slots + cursor.position, cursor.slots + cursor.end, slot) - cursor.slots;
+                skip_removed(cursor);
+                score_bound -= cursor.max_score;
+                if (cursor.position < cursor.end && cursor.slots[cursor.position] == slot) {
+                    contributions[cursor.term_index] = cursor.term_freqs[cursor.position] * cursor.inverse_document_freq;
+                    has_term[cursor.term_index] = 1;
+                    score_bound += contributions[cursor.term_index];
+                }
+            }
+            if (score_bound < threshold) {
+                continue;
+            }
+
+            double relevance = 0.0;
+            for (size_t i = 0; i < term_count; ++i) {
+                if (has_term[i]) {
+                    relevance += contributions[i];
+                }
+            }
+            collector.Push({documents_.GetId(slot), relevance, documents_.GetRating(slot)});
+
+            if (collector.IsFull()) {
+                threshold = collector.MinRelevance() - RELEVANCE_EPSILON;
+                while (essential_begin < order.size() && bound_prefix[essential_begin + 1] < threshold) {
+                    ++essential_begin;
+                }
             }
         }
+    }
+
+    // Отмечает в bitmap слоты документов, в которых есть минус-слова запроса, и возвращает её.
+    // Без минус-слов карта не очищается и возвращается nullptr: исключённых документов нет
+    const SlotBitmap* MarkExcludedSlots(const Query& query, SlotBitmap& bitmap) const;
+
+    static bool IsExcluded(const SlotBitmap* excluded_slots, DocumentSlot slot) {
+        return excluded_slots != nullptr && excluded_slots->Test(slot);
+    }
 
-        std::vector<Document> matched_documents;
-        for (const auto [document_id, relevance] : document_to_relevance) {
-            matched_documents.push_back({document_id, relevance, documents_.at(document_id).rating});
+    // полный перебор: релевантность всех документов, подходящих под запрос
+    template <typename ExecutionPolicy, typename DocumentPredicate>
+    std::vector<Document> FindAllDocuments(ExecutionPolicy&& policy, const SearchServer::Query& query, StatusMask statuses, const SlotBitmap* excluded_slots, DocumentPredicate document_predicate) const {
+        // длинные списки вхождений режем на куски, чтобы слова с частыми вхождениями не доставались одному потоку
+        const auto plus_ranges = SplitPostings(query.plus_terms, statuses);
+
+        ConcurrentMap<DocumentSlot, double> document_to_relevance(RELEVANCE_BUCKET_COUNT);
+        {
+            PROFILE_SCOPE("postings");
+            std::for_each(
+                policy,
+                plus_ranges.begin(), plus_ranges.end(),
+                [this, &document_to_relevance, &excluded_slots, &document_predicate](const PostingRange& range) {
+                    const auto& slots = range.postings->Slots(range.status);
+                    const auto& term_freqs = range.postings->TermFreqs(range.status);
+                    for (size_t i = range.first; i < range.last; ++i) {
+                        if (!PostingList::IsRemoved(term_freqs[i]) && !IsExcluded(excluded_slots, slots[i]) && MatchesPredicate(slots[i], document_predicate)) {
+                            document_to_relevance[slots[i]].ref_to_value += term_freqs[i] * range.inverse_document_freq;
+                        }
+                    }
+                }
+            );
+        }
+
+        PROFILE_SCOPE("result");
+        return BuildMatchedDocuments(document_to_relevance.BuildOrdinaryMap());
+    }
+
+    // документ пакетного матчинга: слот и номер в результате
+    using MatchTarget = std::pair<DocumentSlot, size_t>;
+
+    // Вызывает visit(номер документа в результате, id слова) для каждого документа из [first, last) (отсортированы по слоту)
+    // и каждого слова из terms, которое в нём есть, если в документе нет минус-слов. Слова документа перебираются в порядке terms.
+    // Короткий список документов ищется в длинном списке вхождений двоичным поиском, иначе списки сливаются
+    template <typename Visit>
+    void ForEachMatchedTerm(const std::vector<TermId>& terms, const SlotBitmap* excluded_slots, const MatchTarget* first, const MatchTarget* last, Visit visit) const {
+        for (const TermId term_id : terms) {
+            const PostingList& postings = postings_[term_id];
+            for (size_t status_index = 0; status_index < DOCUMENT_STATUS_COUNT; ++status_index) {
+                const auto status = static_cast<DocumentStatus>(status_index);
+                const auto& slots = postings.Slots(status);
+                const auto& term_freqs = postings.TermFreqs(status);
+                auto posting = slots.begin();
+                const auto posting_end = slots.end();
+                const bool use_search = static_cast<size_t>(last - first) * BINARY_SEARCH_COST < static_cast<size_t>(posting_end - posting);
+                for (const MatchTarget* target = first; target != last && posting != posting_end; ++target) {
+                    if (use_search) {
+                        posting = std::lower_bound(posting, posting_end, target->first);
+                    } else {
+                        while (posting != posting_end && *posting < target->first) {
+                            ++posting;
+                        }
+                    }
+                    if (posting != posting_end && *posting == target->first && !PostingList::IsRemoved(term_freqs[posting - slots.begin()])
+                        && !IsExcluded(excluded_slots, target->first)) {
+                        visit(target->second, term_id);
+                    }
+                }
+            }
         }
-        return matched_documents;
+    }
+
+    // во сколько раз двоичный поиск по списку вхождений дороже шага слияния
+    static constexpr size_t BINARY_SEARCH_COST = 16;
+
+    std::vector<PostingRange> SplitPostings(const std::vector<TermId>& term_ids, StatusMask statuses) const;
+    std::vector<Document> BuildMatchedDocuments(const std::map<DocumentSlot, double>& document_to_relevance) const;
+
+    template <typename DocumentPredicate>
+    bool MatchesPredicate(DocumentSlot slot, DocumentPredicate& document_predicate) const {
+        return document_predicate(documents_.GetId(slot), documents_.GetStatus(slot), documents_.GetRating(slot));
     }
 };
 
@@ -170,68 +546,247 @@ SearchServer::SearchServer(const StringContainer& stop_words)
     }
 }
 
+template <typename ExecutionPolicy>
+std::vector<Document> SearchServer::FindTopDocuments(ExecutionPolicy&& policy, const std::string_view raw_query, DocumentStatus status, ResultWindow window) const {
+    PROFILE_SCOPE("FindTopDocuments");
+    return WithScratch<Query, ExecutionPolicy>([&](Query& query) {
+        {
+            PROFILE_SCOPE("parse");
+            ParseQuery(raw_query, query);
+        }
+        return FindTopDocuments(policy, query, status, window);
+    });
+}
+
+template <typename ExecutionPolicy>
+std::vector<Document> SearchServer::FindTopDocuments(ExecutionPolicy&& policy, const Query& query, DocumentStatus status, ResultWindow window) const {
+    // обходятся только вхождения документов с нужным статусом, остальные условия не проверяются
+    StatusMask statuses;
+    statuses.set(static_cast<size_t>(status));
+    const auto document_predicate = [](int, DocumentStatus, int) {
+        return true;
+    };
+    if (!result_cache_.IsEnabled()) {
+        return FindTopDocuments(policy, query, statuses, document_predicate, window);
+    }
+
+    ResultCacheKey key{query.plus_terms, query.minus_terms, status, window.offset, window.count};
+    if (auto documents = result_cache_.Find(key, generation_)) {
+        return std::move(*documents);
+    }
+    auto documents = FindTopDocuments(policy, query, statuses, document_predicate, window);
+    result_cache_.Insert(std::move(key), generation_, documents);
+    return documents;
+}
+
+template <typename ExecutionPolicy>
+void SearchServer::AddDocuments(ExecutionPolicy&& policy, const std::vector<DocumentToAdd>& documents) {
+    // разбор текстов не трогает индекс, поэтому выполняется параллельно; исключения из потоков выпускать нельзя
+    std::vector<std::vector<std::pair<std::string_view, double>>> word_freqs(documents.size());
+    std::vector<std::exception_ptr> errors(documents.size());
+    std::for_each(
+        policy,
+        word_freqs.begin(), word_freqs.end(),
+        [this, &documents, &word_freqs, &errors](auto& document_word_freqs) {
+            const size_t index = &document_word_freqs - word_freqs.data();
+            try {
+                document_word_freqs = ComputeWordFreqs(documents[index].text);
+            } catch (...) {
+                errors[index] = std::current_exception();
+            }
+        }
+    );
+
+    std::unordered_set<int> batch_ids;
+    for (size_t i = 0; i < documents.size(); ++i) {
+        const int document_id = documents[i].id;
+        if ((document_id < 0) || documents_.Contains(document_id) || !batch_ids.insert(document_id).second) {
+            throw std::invalid_argument("Invalid document_id");
+        }
+        if (errors[i]) {
+            std::rethrow_exception(errors[i]);
+        }
+    }
+
+    // словарь пополняется последовательно, затем вхождения раскладываются по словам подсчётом,
+    // чтобы каждый список вхождений дописывался одним потоком
+    std::vector<DocumentSlot> slots;
+    slots.reserve(documents.size());
+    for (size_t i = 0; i < documents.size(); ++i) {
+        const auto& document = documents[i];
+        std::vector<std::pair<TermId, double>> term_freqs;
+        term_freqs.reserve(word_freqs[i].size());
+        for (const auto& [word, term_freq] : word_freqs[i]) {
+            term_freqs.push_back({terms_.Intern(word), term_freq});
+        }
+        std::sort(term_freqs.begin(), term_freqs.end());
+        slots.push_back(StoreDocument(document.id, document.status, ComputeAverageRating(document.ratings), std::move(term_freqs)));
+    }
+
+    std::vector<size_t> term_offsets(terms_.Size() + 1, 0);
+    for (const DocumentSlot slot : slots) {
+        for (const auto& [term_id, _] : document_data_[slot].term_freqs) {
+            ++term_offsets[term_id + 1];
+        }
+    }
+    std::partial_sum(term_offsets.begin(), term_offsets.end(), term_offsets.begin());
+    std::vector<std::pair<DocumentSlot, double>> new_postings(term_offsets.back());
+    std::vector<size_t> positions(term_offsets.begin(), term_offsets.end() - 1);
+    for (const DocumentSlot slot : slots) {
+        for (const auto& [term_id, term_freq] : document_data_[slot].term_freqs) {
+            new_postings[positions[term_id]++] = {slot, term_freq};
+        }
+    }
+
+    std::vector<TermId> term_ids;
+    for (TermId term_id = 0; term_id < terms_.Size(); ++term_id) {
+        if (term_offsets[term_id] != term_offsets[term_id + 1]) {
+            term_ids.push_back(term_id);
+        }
+    }
+    std::for_each(
+        policy,
+        term_ids.begin(), term_ids.end(),
+        [this, &term_offsets, &new_postings](TermId term_id) {
+            PostingList& postings = postings_[term_id];
+            for (size_t i = term_offsets[term_id]; i < term_offsets[term_id + 1]; ++i) {
+                postings.Add(new_postings[i].first, new_postings[i].second, documents_.GetStatus(new_postings[i].first));
+            }
+        }
+    );
+    ++generation_;
+}
+
 template <typename ExecutionPolicy>
 void SearchServer::RemoveDocument(ExecutionPolicy&& policy, int document_id) {
-    if (documents_.count(document_id) == 0) {
+    if (!documents_.Contains(document_id)) {
         return;
     }
         
-    const auto& word_freqs = documents_.at(document_id).word_freqs;
+    const DocumentSlot slot = documents_.GetSlot(document_id);
+    const DocumentStatus status = documents_.GetStatus(slot);
+    auto& document_data = document_data_[slot];
+    const auto& term_freqs = document_data.term_freqs;
     
-    std::vector<std::string_view> words;
-    words.reserve(word_freqs.size()); 
-    for (const auto& [word, _] : word_freqs) {
-        words.push_back(word);
+    std::vector<PostingList*> postings;
+    postings.reserve(term_freqs.size()); 
+    for (const auto& [term_id, _] : term_freqs) {
+        postings.push_back(&postings_[term_id]);
     }
     
     for_each(
         policy,
-        words.begin(), words.end(),
-        [this, document_id](const auto& word) {
-            this->word_to_document_freqs_[word].erase(document_id);
-            this->words_.erase(word.data());
+        postings.begin(), postings.end(),
+        [slot, status](PostingList* term_postings) {
+            term_postings->Remove(slot, status);
         }
     );
 
-    document_ids_.erase(document_id);    
-    documents_.erase(document_id);
+    document_data = DocumentData{};
+    word_freqs_cache_.word_freqs.erase(slot);
+    documents_.Remove(document_id);
+    ++generation_;
 }
 
 template <typename ExecutionPolicy>
 std::tuple<std::vector<std::string_view>, DocumentStatus> SearchServer::MatchDocument(
     ExecutionPolicy&& policy, const std::string_view raw_query, int document_id) const {
-    const auto query = ParseQuery(raw_query);
+    return WithScratch<Query, ExecutionPolicy>([&](Query& query) {
+        ParseQuery(raw_query, query);
+        return MatchDocument(policy, query, document_id);
+    });
+}
 
-    std::vector<std::string_view> matched_words;
+template <typename ExecutionPolicy>
+std::tuple<std::vector<std::string_view>, DocumentStatus> SearchServer::MatchDocument(
+    ExecutionPolicy&& policy, const Query& query, int document_id) const {
+    const DocumentSlot slot = documents_.GetSlot(document_id);
+    const DocumentStatus status = documents_.GetStatus(slot);
 
-    for_each(
-        policy,
-        query.plus_words.begin(), query.plus_words.end(),
-        [this, &matched_words, document_id](const auto& word) {
-            const auto it = this->words_.find(word);
-            if (it == this->words_.end()) {
-                return;
-            }
-            if (this->word_to_document_freqs_.at(*it).count(document_id)) {
-                matched_words.push_back(*it);
-            }
-        }
-    );
+    const auto contains = [this, slot, status](TermId term_id) {
+        return postings_[term_id].Contains(slot, status);
+    };
+    if (std::any_of(policy, query.minus_terms.begin(), query.minus_terms.end(), contains)) {
+        return {std::vector<std::string_view>{}, status};
+    }
 
-    for_each(
+    // каждый поток пишет только в свой элемент; слова непустые, так что пустая строка отмечает отсутствующее слово
+    std::vector<std::string_view> matched_words(query.plus_terms.size());
+    std::transform(
         policy,
-        query.minus_words.begin(), query.minus_words.end(),
-        [this, &matched_words, document_id](const auto& word) {
-            const auto it = this->words_.find(word);
-            if (it == this->words_.end()) {
-                return;
-            }
-            if (word_to_document_freqs_.at(*it).count(document_id)) {
-                matched_words.clear();
-                return;
-            }
+        query.plus_terms.begin(), query.plus_terms.end(),
+        matched_words.begin(),
+        [this, &contains](TermId term_id) {
+            return contains(term_id) ? terms_.GetWord(term_id) : std::string_view{};
         }
     );
+    matched_words.erase(std::remove(matched_words.begin(), matched_words.end(), std::string_view{}), matched_words.end());
+
+    // id слов выдаются в порядке добавления, а слова возвращаем в алфавитном порядке, как раньше
+    std::sort(matched_words.begin(), matched_words.end());
+
+    return {matched_words, status};
+}
+
+template <typename ExecutionPolicy>
+MatchedDocuments SearchServer::MatchDocuments(ExecutionPolicy&& policy, const std::string_view raw_query, const std::vector<int>& document_ids) const {
+    return WithScratch<Query, ExecutionPolicy>([&](Query& query) {
+        ParseQuery(raw_query, query);
+        return MatchDocuments(policy, query, document_ids);
+    });
+}
 
-    return {matched_words, documents_.at(document_id).status};
-}
\ No newline at end of file
+template <typename ExecutionPolicy>
+MatchedDocuments SearchServer::MatchDocuments(ExecutionPolicy&& policy, const Query& query, const std::vector<int>& document_ids) const {
+    MatchedDocuments result;
+    result.document_ids = document_ids;
+    result.statuses.reserve(document_ids.size());
+    std::vector<MatchTarget> targets;
+    targets.reserve(document_ids.size());
+    for (size_t i = 0; i < document_ids.size(); ++i) {
+        const DocumentSlot slot = documents_.GetSlot(document_ids[i]);
+        result.statuses.push_back(documents_.GetStatus(slot));
+        targets.emplace_back(slot, i);
+    }
+    std::sort(targets.begin(), targets.end());
+
+    SlotBitmap bitmap;
+    const SlotBitmap* excluded_slots = MarkExcludedSlots(query, bitmap);
+    // MatchDocument возвращает слова по алфавиту, поэтому в таком порядке и обходим слова
+    std::vector<TermId> plus_terms = query.plus_terms;
+    std::sort(plus_terms.begin(), plus_terms.end(), [this](TermId lhs, TermId rhs) {
+        return terms_.GetWord(lhs) < terms_.GetWord(rhs);
+    });
+
+    // Документ целиком принадлежит одной части, поэтому потоки пишут в разные элементы offsets и words.
+    // Первый проход считает слова документов, второй раскладывает их по местам
+    const size_t chunk_size = IS_SEQUENCED<ExecutionPolicy> ? std::max<size_t>(targets.size(), 1) : MATCH_CHUNK_SIZE;
+    std::vector<size_t> chunk_firsts;
+    for (size_t first = 0; first < targets.size(); first += chunk_size) {
+        chunk_firsts.push_back(first);
+    }
+    const auto for_each_chunk = [&](auto visit) {
+        std::for_each(policy, chunk_firsts.begin(), chunk_firsts.end(), [&](size_t first) {
+            const MatchTarget* targets_first = targets.data() + first;
+            ForEachMatchedTerm(plus_terms, excluded_slots, targets_first, targets_first + std::min(chunk_size, targets.size() - first), visit);
+        });
+    };
+
+    result.offsets.assign(document_ids.size() + 1, 0);
+    for_each_chunk([&result](size_t index, TermId) {
+        ++result.offsets[index + 1];
+    });
+    std::partial_sum(result.offsets.begin(), result.offsets.end(), result.offsets.begin());
+
+    result.words.resize(result.offsets.back());
+    std::vector<size_t> positions(result.offsets.begin(), result.offsets.end() - 1);
+    for_each_chunk([this, &result, &positions](size_t index, TermId term_id) {
+        result.words[positions[index]++] = terms_.GetWord(term_id);
+    });
+    return result;
+}
+
+template <typename ExecutionPolicy>
+MatchedDocuments SearchServer::MatchDocuments(ExecutionPolicy&& policy, const std::string_view raw_query) const {
+    return MatchDocuments(policy, raw_query, std::vector<int>(begin(), end()));
+}
@@ -0,0 +1,15 @@
+#include "slot_bitmap.h"
+
+using namespace std;
+
+void SlotBitmap::Reset(size_t slot_count) {
+    // память прошлых запросов переиспользуется, очищаем только заполненные ими слова
+    for (const uint32_t word : used_words_) {
+        words_[word] = 0;
+    }
+    used_words_.clear();
+    const size_t word_count = (slot_count + WORD_BITS - 1) / WORD_BITS;
+    if (words_.size() < word_count) {
+        words_.resize(word_count);
+    }
+}
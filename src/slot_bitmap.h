@@ -0,0 +1,32 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "document_store.h"
+
+// Множество слотов документов в виде битовой карты.
+// Карта помнит, какие слова в ней заполнены, и при очистке обнуляет только их
+class SlotBitmap {
+public:
+    // очищает карту и делает её достаточной для слотов [0, slot_count)
+    void Reset(size_t slot_count);
+
+    void Set(DocumentSlot slot) {
+        uint64_t& word = words_[slot / WORD_BITS];
+        if (word == 0) {
+            used_words_.push_back(slot / WORD_BITS);
+        }
+        word |= uint64_t{1} << (slot % WORD_BITS);
+    }
+    bool Test(DocumentSlot slot) const {
+        return (words_[slot / WORD_BITS] >> (slot % WORD_BITS)) & 1;
+    }
+
+private:
+    static constexpr size_t WORD_BITS = 64;
+
+    std::vector<uint64_t> words_;
+    // номера ненулевых слов words_
+    std::vector<uint32_t> used_words_;
+};
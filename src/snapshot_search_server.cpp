@@ -0,0 +1,23 @@
+#include <execution>
+
+#include "snapshot_search_server.h"
+
+using namespace std;
+
+SnapshotSearchServer::SnapshotSearchServer(SearchServer search_server)
+    : current_(make_shared<const SearchServer>(move(search_server))) {
+}
+
+shared_ptr<const SearchServer> SnapshotSearchServer::GetSnapshot() const {
+    return atomic_load(&current_);
+}
+
+int SnapshotSearchServer::GetDocumentCount() const {
+    return GetSnapshot()->GetDocumentCount();
+}
+
+void SnapshotSearchServer::AddDocuments(const vector<DocumentToAdd>& documents) {
+    Update([&documents](SearchServer& search_server) {
+        search_server.AddDocuments(execution::par, documents);
+    });
+}
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <memory>
+#include <mutex>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "search_server.h"
+
+// Поисковый сервер, который можно читать из многих потоков во время обновлений.
+// Читатели закрепляют неизменяемую версию индекса и ищут по ней без блокировок,
+// писатель меняет копию последней версии и атомарно публикует её.
+// Старая версия освобождается, когда её отпустит последний читатель.
+// Само закрепление не lock-free: std::atomic_load / std::atomic_store для shared_ptr в libstdc++ берут
+// спин-блокировку из общей таблицы, выбранную по адресу указателя, на время копирования указателя и счётчика ссылок.
+// std::atomic<std::shared_ptr> из C++20 в libstdc++ устроен так же, только блокировка хранится в самом указателе
+
+class SnapshotSearchServer {
+public:
+    explicit SnapshotSearchServer(SearchServer search_server);
+
+    std::shared_ptr<const SearchServer> GetSnapshot() const;
+
+    template <typename... Args>
+    std::vector<Document> FindTopDocuments(Args&&... args) const {
+        return GetSnapshot()->FindTopDocuments(std::forward<Args>(args)...);
+    }
+
+    // слова ссылаются на хранилище, общее для всех версий, и остаются валидными после обновлений
+    template <typename... Args>
+    std::tuple<std::vector<std::string_view>, DocumentStatus> MatchDocument(Args&&... args) const {
+        return GetSnapshot()->MatchDocument(std::forward<Args>(args)...);
+    }
+
+    int GetDocumentCount() const;
+
+    // Каждое изменение копирует весь индекс, поэтому обёрток для изменения одного документа нет:
+    // изменения собираются в пакет и применяются одним Update.
+    // Если updater бросит исключение, новая версия не публикуется
+    template <typename Updater>
+    void Update(Updater updater);
+
+    void AddDocuments(const std::vector<DocumentToAdd>& documents);
+
+private:
+    // читается и записывается только через std::atomic_load / std::atomic_store
+    std::shared_ptr<const SearchServer> current_;
+    std::mutex update_mutex_;
+};
+
+template <typename Updater>
+void SnapshotSearchServer::Update(Updater updater) {
+    std::lock_guard guard(update_mutex_);
+    auto next = std::make_shared<SearchServer>(*std::atomic_load(&current_));
+    updater(*next);
+    std::atomic_store(&current_, std::shared_ptr<const SearchServer>(std::move(next)));
+}
@@ -1,44 +1,107 @@
 #include <utility>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <immintrin.h>
+#define SEARCH_SERVER_X86_SIMD
+#endif
+
 #include "string_processing.h"
 
 using namespace std;
 
-vector<string> SplitIntoWords(const string_view text) {
-    vector<string> words;
-    string word;
-    for (const char c : text) {
-        if (c == ' ') {
-            if (!word.empty()) {
-                words.push_back(move(word));
-                word.clear();
-            }
-        } else {
-            word += c;
-        }
+namespace {
+
+CharMasks ClassifyCharsScalar(const char* data, size_t size, size_t first = 0) {
+    CharMasks masks;
+    for (size_t i = first; i < size; ++i) {
+        const unsigned char c = static_cast<unsigned char>(data[i]);
+        masks.spaces |= uint64_t{c == ' '} << i;
+        masks.controls |= uint64_t{c < ' '} << i;
     }
-    if (!word.empty()) {
-        words.push_back(move(word));
+    return masks;
+}
+
+#ifdef SEARCH_SERVER_X86_SIMD
+
+__attribute__((target("sse2")))
+CharMasks ClassifyCharsSse2(const char* data, size_t size) {
+    const __m128i spaces = _mm_set1_epi8(' ');
+    const __m128i max_control = _mm_set1_epi8(' ' - 1);
+    CharMasks masks;
+    size_t i = 0;
+    for (; i + 16 <= size; i += 16) {
+        const __m128i chars = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+        const uint64_t space_bits = static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(chars, spaces)));
+        // беззнаковое сравнение c <= 31 через min
+        const uint64_t control_bits = static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_min_epu8(chars, max_control), chars)));
+        masks.spaces |= space_bits << i;
+        masks.controls |= control_bits << i;
     }
+    const CharMasks tail = ClassifyCharsScalar(data, size, i);
+    masks.spaces |= tail.spaces;
+    masks.controls |= tail.controls;
+    return masks;
+}
 
-    return words;
+__attribute__((target("avx2")))
+CharMasks ClassifyCharsAvx2(const char* data, size_t size) {
+    const __m256i spaces = _mm256_set1_epi8(' ');
+    const __m256i max_control = _mm256_set1_epi8(' ' - 1);
+    CharMasks masks;
+    size_t i = 0;
+    for (; i + 32 <= size; i += 32) {
+        const __m256i chars = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i));
+        const uint64_t space_bits = static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(chars, spaces)));
+        const uint64_t control_bits = static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(_mm256_min_epu8(chars, max_control), chars)));
+        masks.spaces |= space_bits << i;
+        masks.controls |= control_bits << i;
+    }
+    const CharMasks tail = ClassifyCharsScalar(data, size, i);
+    masks.spaces |= tail.spaces;
+    masks.controls |= tail.controls;
+    return masks;
 }
 
-vector<string_view> SplitIntoWordsView(const string_view text) {
-    vector<string_view> words;
-    string word;
-    for (const char c : text) {
-        if (c == ' ') {
-            if (!word.empty()) {
-                words.push_back(word);
-                word.clear();
-            }
-        } else {
-            word += c;
-        }
+#endif
+
+using ClassifyCharsFunction = CharMasks (*)(const char*, size_t);
+
+CharMasks ClassifyCharsPortable(const char* data, size_t size) {
+    return ClassifyCharsScalar(data, size);
+}
+
+ClassifyCharsFunction SelectClassifyChars() {
+#ifdef SEARCH_SERVER_X86_SIMD
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) {
+        return ClassifyCharsAvx2;
     }
-    if (!word.empty()) {
-        words.push_back(move(word));
+    if (__builtin_cpu_supports("sse2")) {
+        return ClassifyCharsSse2;
     }
+#endif
+    return ClassifyCharsPortable;
+}
+
+}  // namespace
+
+CharMasks ClassifyChars(const char* data, size_t size) {
+    static const ClassifyCharsFunction classify = SelectClassifyChars();
+    return classify(data, size);
+}
 
+vector<string> SplitIntoWords(const string_view text) {
+    vector<string> words;
+    ForEachWord(text, [&words](const string_view word) {
+        words.emplace_back(word);
+    });
+    return words;
+}
+
+vector<string_view> SplitIntoWordsView(const string_view text) {
+    vector<string_view> words;
+    ForEachWord(text, [&words](const string_view word) {
+        words.push_back(word);
+    });
     return words;
 }
@@ -1,24 +1,93 @@
 #pragma once 
 
+#include <algorithm>
+#include <cstdint>
 #include <vector>
 #include <string>
 #include <string_view>
 #include <set>
 #include <unordered_set>
 
+const size_t SCAN_BLOCK_SIZE = 64;
+
+// Маски символов блока текста длиной до SCAN_BLOCK_SIZE байт: бит i описывает i-й символ
+struct CharMasks {
+    uint64_t spaces = 0;
+    // управляющие символы с кодами 0..31, из-за которых слово считается некорректным
+    uint64_t controls = 0;
+};
+
+// Реализация (AVX2, SSE2 или побайтовая) выбирается один раз при первом вызове
+CharMasks ClassifyChars(const char* data, size_t size);
+
+// Разбивает text на слова за один проход по блокам, вызывая action(word, is_valid).
+// Слова — string_view на text, is_valid == false, если в слове есть управляющие символы
+template <typename Action>
+void ScanWords(const std::string_view text, Action action);
+
+// Вызывает action для каждого слова text. Слова — string_view на text, память не выделяется
+template <typename Action>
+void ForEachWord(const std::string_view text, Action action);
+
 std::vector<std::string> SplitIntoWords(const std::string_view text);
 std::vector<std::string_view> SplitIntoWordsView(const std::string_view text);
 
 template <typename StringContainer>
-std::set<std::string> MakeUniqueNonEmptyStrings(const StringContainer& strings);
+std::set<std::string, std::less<>> MakeUniqueNonEmptyStrings(const StringContainer& strings);
+
+
+template <typename Action>
+void ScanWords(const std::string_view text, Action action) {
+    size_t word_begin = 0;
+    bool in_word = false;
+    bool has_controls = false;
+    for (size_t block_begin = 0; block_begin < text.size(); block_begin += SCAN_BLOCK_SIZE) {
+        const size_t block_size = std::min(SCAN_BLOCK_SIZE, text.size() - block_begin);
+        const CharMasks masks = ClassifyChars(text.data() + block_begin, block_size);
+        const uint64_t used = block_size == SCAN_BLOCK_SIZE ? ~uint64_t{0} : (uint64_t{1} << block_size) - 1;
+
+        // бит i установлен, если символ i - 1 — пробел; перед первым символом блока смотрим на предыдущий блок
+        const uint64_t after_space = (masks.spaces << 1) | (in_word ? 0 : 1);
+        const uint64_t starts = ~masks.spaces & after_space & used;
+        const uint64_t ends = masks.spaces & ~after_space;
 
+        // начало текущего слова внутри блока: 0, если слово началось в одном из прошлых блоков
+        size_t segment_begin = 0;
+        for (uint64_t events = starts | ends; events != 0; events &= events - 1) {
+            const size_t pos = __builtin_ctzll(events);
+            if ((starts >> pos) & 1) {
+                word_begin = block_begin + pos;
+                segment_begin = pos;
+                in_word = true;
+                has_controls = false;
+            } else {
+                has_controls = has_controls || ((masks.controls & ((uint64_t{1} << pos) - 1)) >> segment_begin) != 0;
+                action(text.substr(word_begin, block_begin + pos - word_begin), !has_controls);
+                in_word = false;
+            }
+        }
+        if (in_word) {
+            has_controls = has_controls || (masks.controls >> segment_begin) != 0;
+        }
+    }
+    if (in_word) {
+        action(text.substr(word_begin), !has_controls);
+    }
+}
+
+template <typename Action>
+void ForEachWord(const std::string_view text, Action action) {
+    ScanWords(text, [&action](const std::string_view word, bool) {
+        action(word);
+    });
+}
 
 template <typename StringContainer>
-std::set<std::string> MakeUniqueNonEmptyStrings(const StringContainer& strings) {
-    std::set<std::string> non_empty_strings;
+std::set<std::string, std::less<>> MakeUniqueNonEmptyStrings(const StringContainer& strings) {
+    std::set<std::string, std::less<>> non_empty_strings;
     for (const auto& str : strings) {
         if (!str.empty()) {
-            non_empty_strings.insert(str.data());
+            non_empty_strings.emplace(str);
         }
     }
     return non_empty_strings;
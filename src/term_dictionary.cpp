@@ -0,0 +1,48 @@
+#include <cstring>
+
+#include "term_dictionary.h"
+
+using namespace std;
+
+TermDictionary::TermDictionary()
+    : storage_(make_shared<WordStorage>()) {
+}
+
+TermId TermDictionary::Intern(string_view word) {
+    const auto it = term_ids_->find(word);
+    if (it != term_ids_->end()) {
+        return it->second;
+    }
+    // у перемещённого словаря хранилища нет
+    if (!storage_) {
+        storage_ = make_shared<WordStorage>();
+    }
+    char* data;
+    {
+        // хранилище может пополняться и из других копий словаря
+        lock_guard guard(storage_->mutex);
+        data = static_cast<char*>(storage_->arena.allocate(word.size(), alignof(char)));
+    }
+    memcpy(data, word.data(), word.size());
+    const string_view stored_word(data, word.size());
+    const TermId term_id = static_cast<TermId>(words_.size());
+    words_.push_back(stored_word);
+    term_ids_->emplace(stored_word, term_id);
+    return term_id;
+}
+
+optional<TermId> TermDictionary::Find(string_view word) const {
+    const auto it = term_ids_->find(word);
+    if (it == term_ids_->end()) {
+        return nullopt;
+    }
+    return it->second;
+}
+
+string_view TermDictionary::GetWord(TermId term_id) const {
+    return words_[term_id];
+}
+
+size_t TermDictionary::Size() const {
+    return words_.size();
+}
@@ -0,0 +1,41 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <memory_resource>
+#include <mutex>
+#include <optional>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "pooled_container.h"
+
+using TermId = uint32_t;
+
+// Хранит каждое слово один раз и выдаёт ему плотный числовой id.
+// Текст слов лежит подряд в больших блоках общего для всех копий словаря хранилища, которое только пополняется,
+// поэтому string_view на слова остаются валидными, пока жива хотя бы одна копия.
+// Узлы хеш-таблицы слов берутся из пула словаря
+class TermDictionary {
+public:
+    TermDictionary();
+
+    TermId Intern(std::string_view word);
+    std::optional<TermId> Find(std::string_view word) const;
+
+    std::string_view GetWord(TermId term_id) const;
+    size_t Size() const;
+
+private:
+    struct WordStorage {
+        std::mutex mutex;
+        std::pmr::monotonic_buffer_resource arena{WORD_STORAGE_BLOCK_SIZE};
+    };
+
+    static constexpr size_t WORD_STORAGE_BLOCK_SIZE = 64 * 1024;
+
+    std::shared_ptr<WordStorage> storage_;
+    std::vector<std::string_view> words_;
+    PooledContainer<std::pmr::unordered_map<std::string_view, TermId>> term_ids_;
+};
@@ -0,0 +1,117 @@
+#include <algorithm>
+
+#include "thread_pool.h"
+
+using namespace std;
+
+namespace {
+
+// номер очереди потока пула, который сейчас выполняется; у сторонних потоков — NO_QUEUE
+const size_t NO_QUEUE = SIZE_MAX;
+thread_local const ThreadPool* current_pool = nullptr;
+thread_local size_t current_queue_index = NO_QUEUE;
+
+}  // namespace
+
+ThreadPool::ThreadPool(size_t thread_count) {
+    thread_count = max<size_t>(thread_count, 1);
+    queues_.reserve(thread_count);
+    for (size_t i = 0; i < thread_count; ++i) {
+        queues_.push_back(make_unique<WorkQueue>());
+    }
+    workers_.reserve(thread_count);
+    for (size_t i = 0; i < thread_count; ++i) {
+        workers_.emplace_back([this, i] {
+            WorkerLoop(i);
+        });
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        lock_guard guard(wake_mutex_);
+        is_stopping_ = true;
+    }
+    wake_.notify_all();
+    for (thread& worker : workers_) {
+        worker.join();
+    }
+}
+
+size_t ThreadPool::GetThreadCount() const {
+    return workers_.size();
+}
+
+void ThreadPool::Post(vector<Task> tasks) {
+    if (tasks.empty()) {
+        return;
+    }
+    {
+        lock_guard guard(wake_mutex_);
+        pending_count_ += tasks.size();
+    }
+    // Задачи раскладываются по очередям поровну, дальше потоки выравнивают нагрузку перехватом.
+    // Владелец берёт задачи с конца очереди, поэтому кладём их туда в обратном порядке
+    const size_t queue_count = queues_.size();
+    const size_t first_queue = current_pool == this ? current_queue_index : 0;
+    for (size_t q = 0; q < min(queue_count, tasks.size()); ++q) {
+        WorkQueue& queue = *queues_[(first_queue + q) % queue_count];
+        lock_guard guard(queue.mutex);
+        const size_t last = q + (tasks.size() - 1 - q) / queue_count * queue_count;
+        for (size_t i = last + queue_count; i > q;) {
+            i -= queue_count;
+            queue.tasks.push_back(move(tasks[i]));
+        }
+    }
+    wake_.notify_all();
+}
+
+bool ThreadPool::TryRunTask() {
+    const size_t queue_count = queues_.size();
+    const bool is_worker = current_pool == this;
+    const size_t own_queue = is_worker ? current_queue_index : 0;
+
+    Task task;
+    for (size_t q = 0; q < queue_count && !task; ++q) {
+        WorkQueue& queue = *queues_[(own_queue + q) % queue_count];
+        lock_guard guard(queue.mutex);
+        if (queue.tasks.empty()) {
+            continue;
+        }
+        if (is_worker && q == 0) {
+            task = move(queue.tasks.back());
+            queue.tasks.pop_back();
+        } else {
+            task = move(queue.tasks.front());
+            queue.tasks.pop_front();
+        }
+    }
+    if (!task) {
+        return false;
+    }
+    --pending_count_;
+    task();
+    return true;
+}
+
+void ThreadPool::WorkerLoop(size_t queue_index) {
+    current_pool = this;
+    current_queue_index = queue_index;
+    while (true) {
+        if (TryRunTask()) {
+            continue;
+        }
+        unique_lock lock(wake_mutex_);
+        wake_.wait(lock, [this] {
+            return is_stopping_ || pending_count_ > 0;
+        });
+        if (is_stopping_ && pending_count_ == 0) {
+            return;
+        }
+    }
+}
+
+ThreadPool& GetDefaultThreadPool() {
+    static ThreadPool pool;
+    return pool;
+}
@@ -0,0 +1,106 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Пул потоков с перехватом работы: у каждого потока своя очередь задач, свои задачи он берёт с конца,
+// а когда они кончаются, забирает задачи из начала чужих очередей. Потоки живут до разрушения пула,
+// поэтому их thread_local-буферы переиспользуются между вызовами
+class ThreadPool {
+public:
+    explicit ThreadPool(size_t thread_count = std::thread::hardware_concurrency());
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+    ~ThreadPool();
+
+    using Task = std::function<void()>;
+
+    size_t GetThreadCount() const;
+
+    // Ставит задачи в очереди и не ждёт их выполнения. Задачи берутся примерно в порядке вектора;
+    // исключения из них не перехватываются, поэтому задача должна обрабатывать их сама
+    void Post(std::vector<Task> tasks);
+
+    // Вызывает func(i) для каждого i из [0, count) в потоках пула и ждёт завершения всех вызовов.
+    // Каждый вызов — отдельная задача, так что долгие и короткие вызовы распределяются по потокам сами.
+    // Ожидающий поток тоже выполняет задачи, поэтому ParallelFor можно вызывать из задачи пула.
+    // Первое исключение из func пробрасывается после завершения остальных вызовов
+    template <typename Func>
+    void ParallelFor(size_t count, Func func);
+
+private:
+    struct WorkQueue {
+        std::mutex mutex;
+        std::deque<Task> tasks;
+    };
+
+    std::vector<std::unique_ptr<WorkQueue>> queues_;
+    std::vector<std::thread> workers_;
+    // число задач в очередях; увеличивается под wake_mutex_, чтобы потоки не пропустили пробуждение
+    std::atomic<size_t> pending_count_ = 0;
+    std::mutex wake_mutex_;
+    std::condition_variable wake_;
+    bool is_stopping_ = false;
+
+    // выполняет одну задачу: из своей очереди, если поток из пула, иначе из чужой; false, если задач нет
+    bool TryRunTask();
+    void WorkerLoop(size_t queue_index);
+};
+
+template <typename Func>
+void ThreadPool::ParallelFor(size_t count, Func func) {
+    if (count == 0) {
+        return;
+    }
+
+    struct Batch {
+        std::atomic<size_t> remaining_count;
+        std::mutex mutex;
+        std::condition_variable done;
+        std::exception_ptr error;
+    };
+    Batch batch;
+    batch.remaining_count = count;
+
+    std::vector<Task> tasks;
+    tasks.reserve(count);
+    for (size_t i = 0; i < count; ++i) {
+        tasks.push_back([&batch, &func, i] {
+            std::exception_ptr error;
+            try {
+                func(i);
+            } catch (...) {
+                error = std::current_exception();
+            }
+            // счётчик уменьшается под мьютексом: иначе ожидающий поток мог бы разрушить batch раньше, чем мы его отпустим
+            std::lock_guard guard(batch.mutex);
+            if (error && !batch.error) {
+                batch.error = error;
+            }
+            if (--batch.remaining_count == 0) {
+                batch.done.notify_all();
+            }
+        });
+    }
+    Post(std::move(tasks));
+
+    while (batch.remaining_count > 0 && TryRunTask()) {
+    }
+    std::unique_lock lock(batch.mutex);
+    batch.done.wait(lock, [&batch] {
+        return batch.remaining_count == 0;
+    });
+    if (batch.error) {
+        std::rethrow_exception(batch.error);
+    }
+}
+
+// общий пул по числу ядер, создаётся при первом вызове
+ThreadPool& GetDefaultThreadPool();
@@ -0,0 +1,60 @@
+#include <algorithm>
+#include <cmath>
+
+#include "top_documents.h"
+
+using namespace std;
+
+bool IsMoreRelevant(const Document& lhs, const Document& rhs) {
+    if (abs(lhs.relevance - rhs.relevance) < RELEVANCE_EPSILON) {
+        if (lhs.rating != rhs.rating) {
+            return lhs.rating > rhs.rating;
+        }
+        return lhs.id < rhs.id;
+    }
+    return lhs.relevance > rhs.relevance;
+}
+
+TopDocumentsCollector::TopDocumentsCollector(size_t capacity)
+    : capacity_(capacity) {
+    heap_.reserve(capacity);
+}
+
+void TopDocumentsCollector::Push(const Document& document) {
+    if (capacity_ == 0) {
+        return;
+    }
+    if (heap_.size() < capacity_) {
+        heap_.push_back(document);
+        push_heap(heap_.begin(), heap_.end(), IsMoreRelevant);
+    } else if (IsMoreRelevant(document, heap_.front())) {
+        pop_heap(heap_.begin(), heap_.end(), IsMoreRelevant);
+        heap_.back() = document;
+        push_heap(heap_.begin(), heap_.end(), IsMoreRelevant);
+    }
+}
+
+void TopDocumentsCollector::Merge(const TopDocumentsCollector& other) {
+    for (const Document& document : other.heap_) {
+        Push(document);
+    }
+}
+
+bool TopDocumentsCollector::IsFull() const {
+    return heap_.size() == capacity_;
+}
+
+const Document& TopDocumentsCollector::Worst() const {
+    return heap_.front();
+}
+
+double TopDocumentsCollector::MinRelevance() const {
+    return min_element(heap_.begin(), heap_.end(), [](const Document& lhs, const Document& rhs) {
+        return lhs.relevance < rhs.relevance;
+    })->relevance;
+}
+
+vector<Document> TopDocumentsCollector::ExtractSorted() {
+    sort_heap(heap_.begin(), heap_.end(), IsMoreRelevant);
+    return move(heap_);
+}
@@ -0,0 +1,80 @@
+#pragma once
+
+#include <algorithm>
+#include <execution>
+#include <thread>
+#include <vector>
+
+#include "document.h"
+
+const size_t MAX_RESULT_DOCUMENT_COUNT = 5;
+const double RELEVANCE_EPSILON = 1e-6;
+
+// порядок выдачи: по убыванию релевантности, при равной релевантности — по рейтингу, затем по id
+bool IsMoreRelevant(const Document& lhs, const Document& rhs);
+
+// Хранит не больше capacity лучших документов в куче, на вершине которой худший из них
+class TopDocumentsCollector {
+public:
+    explicit TopDocumentsCollector(size_t capacity);
+
+    void Push(const Document& document);
+    void Merge(const TopDocumentsCollector& other);
+
+    bool IsFull() const;
+    const Document& Worst() const;
+    // наименьшая релевантность среди собранных документов; из-за сравнения с точностью RELEVANCE_EPSILON
+    // у Worst() она может быть не самой маленькой
+    double MinRelevance() const;
+
+    std::vector<Document> ExtractSorted();
+
+private:
+    size_t capacity_;
+    std::vector<Document> heap_;
+};
+
+// Возвращает документы с позиций [offset, offset + count) отсортированной выдачи,
+// не сортируя весь вектор целиком
+template <typename ExecutionPolicy>
+std::vector<Document> SelectTopDocuments(ExecutionPolicy&& policy, std::vector<Document> documents, size_t offset, size_t count) {
+    if (offset >= documents.size() || count == 0) {
+        return {};
+    }
+    const size_t limit = std::min(documents.size(), offset + std::min(count, documents.size()));
+
+    std::vector<Document> top;
+    if (limit == documents.size()) {
+        std::sort(policy, documents.begin(), documents.end(), IsMoreRelevant);
+        top = std::move(documents);
+    } else if constexpr (std::is_same_v<std::decay_t<ExecutionPolicy>, std::execution::sequenced_policy>) {
+        TopDocumentsCollector collector(limit);
+        for (const Document& document : documents) {
+            collector.Push(document);
+        }
+        top = collector.ExtractSorted();
+    } else {
+        const size_t shard_count = std::max(1u, std::thread::hardware_concurrency());
+        const size_t shard_size = (documents.size() + shard_count - 1) / shard_count;
+        std::vector<TopDocumentsCollector> shards(shard_count, TopDocumentsCollector(limit));
+        std::for_each(
+            policy,
+            shards.begin(), shards.end(),
+            [&documents, &shards, shard_size](TopDocumentsCollector& shard) {
+                const size_t first = std::min(documents.size(), (&shard - shards.data()) * shard_size);
+                const size_t last = std::min(documents.size(), first + shard_size);
+                for (size_t i = first; i < last; ++i) {
+                    shard.Push(documents[i]);
+                }
+            }
+        );
+        for (size_t i = 1; i < shards.size(); ++i) {
+            shards[0].Merge(shards[i]);
+        }
+        top = shards[0].ExtractSorted();
+    }
+
+    top.erase(top.begin(), top.begin() + offset);
+    top.resize(std::min(top.size(), count));
+    return top;
+}
@@ -0,0 +1,160 @@
+// Нагрузочная проверка SnapshotSearchServer: читатели ищут и матчат документы в закреплённых версиях индекса,
+// пока писатель добавляет, удаляет документы и меняет их статусы. Каждая версия должна быть согласована сама с собой:
+// найденный документ есть в ней и содержит слово запроса. Вместе с -DSEARCH_SERVER_TSAN=ON ловит гонки данных
+
+#include <atomic>
+#include <cstdlib>
+#include <exception>
+#include <execution>
+#include <iostream>
+#include <random>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include "process_queries.h"
+#include "search_server.h"
+#include "snapshot_search_server.h"
+
+using namespace std;
+
+namespace {
+
+const int WORD_COUNT = 300;
+const int DOCUMENT_COUNT = 3'000;
+const int DOCUMENT_LENGTH = 20;
+const int QUERY_COUNT = 20;
+const int BATCH_SIZE = 100;
+const int READER_COUNT = 3;
+
+string MakeWord(int index) {
+    return "w"s + to_string(index);
+}
+
+vector<string> GenerateTexts(mt19937& generator, int count, int length) {
+    uniform_int_distribution<int> word_index(0, WORD_COUNT - 1);
+    vector<string> texts;
+    texts.reserve(count);
+    for (int i = 0; i < count; ++i) {
+        string text;
+        for (int j = 0; j < length; ++j) {
+            text += MakeWord(word_index(generator)) + " "s;
+        }
+        texts.push_back(move(text));
+    }
+    return texts;
+}
+
+vector<string> GenerateQueries(mt19937& generator) {
+    vector<string> queries = GenerateTexts(generator, QUERY_COUNT, 3);
+    for (size_t i = 0; i < queries.size(); i += 2) {
+        queries[i] += "-"s + MakeWord(i);
+    }
+    return queries;
+}
+
+// проверяет выдачу в той версии индекса, по которой она получена; возвращает число ошибок
+int CheckDocuments(const SearchServer& search_server, const string& query, const vector<Document>& documents) {
+    int error_count = 0;
+    for (const Document& document : documents) {
+        try {
+            const auto [words, status] = search_server.MatchDocument(query, document.id);
+            if (words.empty()) {
+                ++error_count;
+            }
+        } catch (const out_of_range&) {
+            ++error_count;
+        }
+    }
+    return error_count;
+}
+
+void RunReader(const SnapshotSearchServer& search_server, const vector<string>& queries, int reader_index,
+               const atomic_bool& done, atomic_int& query_count, atomic_int& error_count) {
+    ThreadPool pool(2);
+    while (!done) {
+        const auto snapshot = search_server.GetSnapshot();
+        for (const string& query : queries) {
+            // читатели обходят разные пути поиска: последовательный, параллельный и пакетный
+            vector<Document> documents;
+            if (reader_index == 0) {
+                documents = snapshot->FindTopDocuments(query);
+            } else if (reader_index == 1) {
+                documents = snapshot->FindTopDocuments(execution::par, query, DocumentStatus::BANNED);
+            } else {
+                documents = ProcessQueries(*snapshot, {query}, pool).front();
+            }
+            error_count += CheckDocuments(*snapshot, query, documents);
+            ++query_count;
+        }
+        const auto matched = snapshot->MatchDocuments(execution::par, queries[query_count % queries.size()]);
+        if (matched.document_ids.size() != static_cast<size_t>(snapshot->GetDocumentCount())) {
+            ++error_count;
+        }
+    }
+}
+
+}  // namespace
+
+int main() {
+    mt19937 generator(42);
+    const vector<string> texts = GenerateTexts(generator, DOCUMENT_COUNT, DOCUMENT_LENGTH);
+    const vector<string> queries = GenerateQueries(generator);
+
+    SearchServer initial_server("and in on"sv);
+    initial_server.SetResultCacheCapacity(64);
+    SnapshotSearchServer search_server{move(initial_server)};
+    atomic_bool done = false;
+    atomic_int query_count = 0;
+    atomic_int error_count = 0;
+
+    vector<thread> readers;
+    for (int i = 0; i < READER_COUNT; ++i) {
+        readers.emplace_back(RunReader, cref(search_server), cref(queries), i, cref(done), ref(query_count), ref(error_count));
+    }
+
+    // пакеты документов добавляются по очереди обоими путями, у каждого третьего пакета меняются статусы,
+    // а пакет двумя шагами раньше удаляется
+    for (int first = 0; first < DOCUMENT_COUNT; first += BATCH_SIZE) {
+        const int last = min(first + BATCH_SIZE, DOCUMENT_COUNT);
+        if (first / BATCH_SIZE % 2 == 0) {
+            search_server.Update([&texts, first, last](SearchServer& server) {
+                for (int id = first; id < last; ++id) {
+                    server.AddDocument(id, texts[id], DocumentStatus::ACTUAL, {id % 5});
+                }
+            });
+        } else {
+            vector<DocumentToAdd> documents;
+            for (int id = first; id < last; ++id) {
+                documents.push_back({id, texts[id], DocumentStatus::ACTUAL, {id % 5}});
+            }
+            search_server.AddDocuments(documents);
+        }
+        if (first / BATCH_SIZE % 3 == 0) {
+            search_server.Update([first, last](SearchServer& server) {
+                for (int id = first; id < last; id += 2) {
+                    server.SetDocumentStatus(id, DocumentStatus::BANNED);
+                }
+            });
+        }
+        if (first >= 2 * BATCH_SIZE) {
+            search_server.Update([first](SearchServer& server) {
+                for (int id = first - 2 * BATCH_SIZE; id < first - BATCH_SIZE; ++id) {
+                    server.RemoveDocument(id);
+                }
+            });
+        }
+    }
+    done = true;
+    for (thread& reader : readers) {
+        reader.join();
+    }
+
+    const int expected_document_count = min(DOCUMENT_COUNT, 2 * BATCH_SIZE);
+    if (search_server.GetDocumentCount() != expected_document_count) {
+        ++error_count;
+    }
+    cout << search_server.GetDocumentCount() << " documents, "s << query_count << " queries, "s << error_count << " errors"s << endl;
+    return error_count == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,128 @@
+// Проверка IngestDocuments на коротких входах и ошибках разбора. Короткие пакеты важны отдельно:
+// их буфер помещается в саму строку, и при перемещении пакета в очередь тексты документов не должны потеряться
+
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "ingest_documents.h"
+#include "search_server.h"
+
+using namespace std;
+
+namespace {
+
+int error_count = 0;
+
+void Check(bool condition, string_view description) {
+    if (!condition) {
+        cerr << "FAILED: "s << description << endl;
+        ++error_count;
+    }
+}
+
+// документ id найден по слову word
+bool HasMatch(const SearchServer& search_server, string_view word, int id) {
+    try {
+        const auto [words, status] = search_server.MatchDocument(word, id);
+        return words.size() == 1 && words.front() == word;
+    } catch (const exception&) {
+        return false;
+    }
+}
+
+void TestSingleShortLine() {
+    SearchServer search_server(""s);
+    istringstream input("1\t0\t1\tcat\n"s);
+    Check(IngestDocuments(search_server, input) == 1, "single short line is added"sv);
+    Check(search_server.GetDocumentCount() == 1, "single short line: document count"sv);
+    Check(HasMatch(search_server, "cat"sv, 1), "single short line: text is kept"sv);
+}
+
+void TestShortLastChunk() {
+    SearchServer search_server(""s);
+    // по два документа в пакете; последний пакет из одной строки короче 16 байт, а в конце входа нет перевода строки
+    istringstream input("1\t0\t5 -3 8\tfluffy white cat\n"s
+                        "2\t1\t\tgroomed dog\r\n"s
+                        "\n"s
+                        "3\t0\t2\tbig parrot with fancy feathers\n"s
+                        "4\t3\t-1\tangry starling\n"s
+                        "5\t0\t1\tfox"s);
+    Check(IngestDocuments(search_server, input, 2) == 5, "short last chunk: all documents are added"sv);
+    Check(HasMatch(search_server, "cat"sv, 1), "short last chunk: document 1"sv);
+    Check(HasMatch(search_server, "dog"sv, 2), "short last chunk: document 2"sv);
+    Check(HasMatch(search_server, "parrot"sv, 3), "short last chunk: document 3"sv);
+    Check(HasMatch(search_server, "starling"sv, 4), "short last chunk: document 4"sv);
+    Check(HasMatch(search_server, "fox"sv, 5), "short last chunk: document 5"sv);
+    const auto [words, status] = search_server.MatchDocument("starling"sv, 4);
+    Check(status == DocumentStatus::REMOVED, "short last chunk: status is parsed"sv);
+}
+
+void TestManyTinyChunks() {
+    SearchServer search_server(""s);
+    // каждый пакет — одна строка со своим словом; чтение следующего пакета не должно портить тексты предыдущих
+    const int document_count = 200;
+    string text;
+    for (int id = 0; id < document_count; ++id) {
+        text += to_string(id) + "\t0\t1\tw"s + to_string(id) + "\n"s;
+    }
+    istringstream input(text);
+    Check(IngestDocuments(search_server, input, 1) == document_count, "tiny chunks: all documents are added"sv);
+    int lost_count = 0;
+    for (int id = 0; id < document_count; ++id) {
+        lost_count += HasMatch(search_server, "w"s + to_string(id), id) ? 0 : 1;
+    }
+    Check(lost_count == 0, "tiny chunks: texts are kept"sv);
+}
+
+void TestEmptyInput() {
+    SearchServer search_server(""s);
+    istringstream input("\n\n"s);
+    Check(IngestDocuments(search_server, input) == 0, "empty input adds nothing"sv);
+}
+
+void CheckRejected(const string& text, string_view description) {
+    SearchServer search_server(""s);
+    istringstream input(text);
+    try {
+        IngestDocuments(search_server, input);
+        Check(false, description);
+    } catch (const invalid_argument&) {
+    }
+}
+
+void TestInvalidLines() {
+    CheckRejected("1\t0\tcat\n"s, "too few fields"sv);
+    CheckRejected("1\n"s, "single field"sv);
+    CheckRejected("x\t0\t1\tcat\n"s, "bad id"sv);
+    CheckRejected("1\t4\t1\tcat\n"s, "status out of range"sv);
+    CheckRejected("1\t-1\t1\tcat\n"s, "negative status"sv);
+    CheckRejected("1\tactual\t1\tcat\n"s, "status is not a number"sv);
+    CheckRejected("1\t0\t1x\tcat\n"s, "bad rating"sv);
+    CheckRejected("1\t0\t99999999999\tcat\n"s, "rating out of int range"sv);
+    CheckRejected("1\t0\t1\tcat\n1\t0\t1\tdog\n"s, "duplicate id"sv);
+}
+
+}  // namespace
+
+int main() {
+    try {
+        TestSingleShortLine();
+        TestShortLastChunk();
+        TestManyTinyChunks();
+        TestEmptyInput();
+        TestInvalidLines();
+    } catch (const exception& error) {
+        cerr << "FAILED: "s << error.what() << endl;
+        ++error_count;
+    }
+    if (error_count == 0) {
+        cout << "OK"s << endl;
+    }
+    return error_count == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}